@@ -0,0 +1,210 @@
+#include "bench_utils.hpp"
+
+#include <putl/atomic_state_ptr.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Usage: atomic_contention_bench [ops per thread] [max threads] [json file]
+//
+// Runs tag-only read-modify-writes and full-word CAS loops on atomic_state_ptr
+// cells shared by 1 to `max threads` threads in three layouts: all threads on
+// the same cell, every thread on its own cell with adjacent cells (false
+// sharing), and every thread on its own cache line (padded). A cache line
+// holds 8 cells, so with more than 8 threads the false sharing cells span
+// several lines, each shared by 8 threads.
+// Latencies are measured per batch of operations to keep timer overhead low.
+// Both counts are clamped to at least 1.
+
+namespace {
+	struct alignas(8) Object {
+		std::uint64_t payload;
+	};
+
+	using cell_type = putl::atomic_state_ptr<Object>;
+
+	/// \brief The number of operations timed together for the latency percentiles.
+	constexpr std::size_t batch_size = 64;
+
+	/// \brief Assumed size of a cache line.
+	constexpr std::size_t cache_line = 64;
+
+	enum class sharing { same, false_sharing, padded };
+
+	auto sharing_name(sharing s) -> char const* {
+		switch (s) {
+			case sharing::same:          return "same";
+			case sharing::false_sharing: return "false_sharing";
+			case sharing::padded:        return "padded";
+		}
+		return "?";
+	}
+
+	/// \brief Cells of all threads placed according to the sharing mode.
+	class cells {
+	public:
+		cells(sharing mode, std::size_t threads, Object* target) :
+			m_stride{mode == sharing::same ? 0 : mode == sharing::false_sharing ? sizeof(cell_type) : cache_line},
+			m_storage((threads + 2) * cache_line)
+		{
+			auto const base = reinterpret_cast<std::uintptr_t>(m_storage.data());
+			m_first = m_storage.data() + ((cache_line - base % cache_line) % cache_line);
+			for (std::size_t t = 0; t < threads; ++t) {
+				new (m_first + t * m_stride) cell_type{{target, 0}};
+			}
+		}
+
+		auto operator[](std::size_t thread) -> cell_type& {
+			return *reinterpret_cast<cell_type*>(m_first + thread * m_stride);
+		}
+
+	private:
+		std::size_t                m_stride;
+		std::vector<unsigned char> m_storage;
+		unsigned char*             m_first;
+	};
+
+	struct result {
+		char const* operation;
+		sharing     mode;
+		std::size_t threads;
+		std::size_t ops;
+		double      seconds;
+		double      p50;
+		double      p90;
+		double      p99;
+		double      p999;
+	};
+
+	auto percentile(std::vector<double> const& sorted, double p) -> double {
+		if (sorted.empty()) {
+			return 0.0;
+		}
+		auto const index = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1));
+		return sorted[index];
+	}
+
+	/// \brief Runs `op(cell, i)` `ops` times on every thread and collects the results.
+	template<typename Op>
+	auto run(char const* operation, sharing mode, std::size_t threads, std::size_t ops, Op op) -> result {
+		Object target{0};
+		cells cs{mode, threads, &target};
+		std::vector<std::vector<double>> latencies(threads);
+		std::atomic<std::size_t> ready{0};
+		std::atomic<bool> go{false};
+		auto const worker = [&](std::size_t t) {
+			auto& cell    = cs[t];
+			auto& samples = latencies[t];
+			samples.reserve(ops / batch_size + 1);
+			ready.fetch_add(1);
+			while (!go.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+			}
+			for (std::size_t done = 0; done < ops; done += batch_size) {
+				auto const n     = std::min(batch_size, ops - done);
+				auto const start = std::chrono::steady_clock::now();
+				for (std::size_t i = 0; i < n; ++i) {
+					op(cell, done + i);
+				}
+				auto const stop = std::chrono::steady_clock::now();
+				samples.push_back(std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(n));
+			}
+		};
+		std::vector<std::thread> workers;
+		for (std::size_t t = 1; t < threads; ++t) {
+			workers.emplace_back(worker, t);
+		}
+		while (ready.load() != threads - 1) {
+			std::this_thread::yield();
+		}
+		bench::stopwatch watch;
+		go.store(true, std::memory_order_release);
+		worker(0);
+		for (auto& w : workers) {
+			w.join();
+		}
+		auto const seconds = watch.elapsed();
+
+		std::vector<double> all;
+		for (auto const& samples : latencies) {
+			all.insert(all.end(), samples.begin(), samples.end());
+		}
+		std::sort(all.begin(), all.end());
+		return result{operation, mode, threads, ops * threads, seconds,
+			percentile(all, 0.5), percentile(all, 0.9), percentile(all, 0.99), percentile(all, 0.999)};
+	}
+
+	void print(result const& r) {
+		auto const name = std::string{r.operation} + " " + sharing_name(r.mode) + " x" + std::to_string(r.threads);
+		std::printf("%-40s %12.2f Mops/s  p50 %8.2f  p90 %8.2f  p99 %8.2f  p99.9 %8.2f ns/op\n",
+			name.c_str(), static_cast<double>(r.ops) / r.seconds / 1e6, r.p50, r.p90, r.p99, r.p999);
+	}
+
+	void write_json(char const* path, std::vector<result> const& results) {
+		auto const file = std::fopen(path, "w");
+		if (file == nullptr) {
+			std::fprintf(stderr, "cannot write %s\n", path);
+			return;
+		}
+		std::fprintf(file, "{\n  \"benchmark\": \"atomic_contention_bench\",\n  \"results\": [\n");
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			auto const& r = results[i];
+			std::fprintf(file,
+				"    {\"operation\": \"%s\", \"sharing\": \"%s\", \"threads\": %zu, \"ops\": %zu, "
+				"\"seconds\": %.9f, \"mops_per_second\": %.3f, "
+				"\"p50_ns\": %.3f, \"p90_ns\": %.3f, \"p99_ns\": %.3f, \"p999_ns\": %.3f}%s\n",
+				r.operation, sharing_name(r.mode), r.threads, r.ops,
+				r.seconds, static_cast<double>(r.ops) / r.seconds / 1e6,
+				r.p50, r.p90, r.p99, r.p999,
+				i + 1 < results.size() ? "," : "");
+		}
+		std::fprintf(file, "  ]\n}\n");
+		std::fclose(file);
+	}
+}
+
+int main(int argc, char** argv) {
+	auto const ops      = std::max<std::size_t>(1, bench::size_arg(argc, argv, 1000000));
+	auto const hardware = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+	auto const max      = argc > 2 ? std::max<std::size_t>(1, static_cast<std::size_t>(std::strtoull(argv[2], nullptr, 10))) : hardware;
+
+	std::vector<std::size_t> thread_counts;
+	for (std::size_t threads = 1; threads < max; threads *= 2) {
+		thread_counts.push_back(threads);
+	}
+	thread_counts.push_back(max);
+
+	std::vector<result> results;
+	for (auto const mode : {sharing::same, sharing::false_sharing, sharing::padded}) {
+		for (auto const threads : thread_counts) {
+			results.push_back(run("fetch_or_state", mode, threads, ops, [](cell_type& cell, std::size_t i) {
+				if (i % 2 == 0) {
+					cell.fetch_or_state(1u, std::memory_order_acq_rel);
+				}
+				else {
+					cell.fetch_and_state(~std::uintptr_t{1}, std::memory_order_acq_rel);
+				}
+			}));
+			results.push_back(run("cas_loop", mode, threads, ops, [](cell_type& cell, std::size_t) {
+				auto expected = cell.load(std::memory_order_relaxed);
+				while (!cell.compare_exchange_weak(expected, {expected.get_ptr(), expected.get_state() ^ 1u}, std::memory_order_acq_rel)) {
+				}
+			}));
+			results.push_back(run("load", mode, threads, ops, [](cell_type& cell, std::size_t) {
+				bench::do_not_optimize(cell.get_state(std::memory_order_acquire));
+			}));
+		}
+	}
+	for (auto const& r : results) {
+		print(r);
+	}
+	if (argc > 3) {
+		write_json(argv[3], results);
+	}
+}
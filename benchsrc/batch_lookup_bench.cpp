@@ -0,0 +1,167 @@
+#include "bench_utils.hpp"
+
+#include <putl/batch_lookup.hpp>
+#include <putl/state_ptr.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Compares the throughput of sequential lookups with batch_lookup for batch
+// widths 1 to 64 on the chains of a hash table and on an unbalanced binary
+// search tree. The first argument is the number of keys, default 1e6.
+
+namespace {
+	struct alignas(8) ChainNode {
+		std::uint64_t                                 key;
+		putl::state_ptr<ChainNode, std::uintptr_t, 1> next;
+		std::uint64_t                                 value;
+	};
+
+	struct alignas(8) TreeNode {
+		std::uint64_t                                key;
+		putl::state_ptr<TreeNode, std::uintptr_t, 1> left;
+		putl::state_ptr<TreeNode, std::uintptr_t, 1> right;
+		std::uint64_t                                value;
+	};
+
+	using chain_ptr = putl::state_ptr<ChainNode, std::uintptr_t, 1>;
+	using tree_ptr  = putl::state_ptr<TreeNode, std::uintptr_t, 1>;
+
+	/// \brief Returns the sum of the values of the found nodes.
+	template<typename Ptr>
+	auto checksum(std::vector<Ptr> const& results) -> std::uint64_t {
+		std::uint64_t sum = 0;
+		for (auto const& p : results) {
+			sum += p ? p->value : 0;
+		}
+		return sum;
+	}
+
+	template<std::size_t Width>
+	void bench_chains(std::vector<chain_ptr> const& heads, std::vector<std::uint64_t> const& queries, std::vector<chain_ptr>& results) {
+		auto const seconds = bench::time_it([&] {
+			putl::batch_lookup<Width>(queries.begin(), queries.end(), results.begin(),
+				[&](std::uint64_t key) { return heads[key % heads.size()]; },
+				[](std::uint64_t key, chain_ptr p) {
+					return p->key == key ? putl::batch_step<chain_ptr>::finish(p) : putl::batch_step<chain_ptr>::follow(p->next);
+				});
+		});
+		char name[64];
+		std::snprintf(name, sizeof(name), "hash chains batch_lookup<%zu>", Width);
+		bench::report(name, queries.size(), seconds);
+		bench::do_not_optimize(checksum(results));
+	}
+
+	template<std::size_t Width>
+	void bench_tree(tree_ptr root, std::vector<std::uint64_t> const& queries, std::vector<tree_ptr>& results) {
+		auto const seconds = bench::time_it([&] {
+			putl::batch_lookup<Width>(queries.begin(), queries.end(), results.begin(),
+				[&](std::uint64_t) { return root; },
+				[](std::uint64_t key, tree_ptr p) {
+					if (p->key == key) {
+						return putl::batch_step<tree_ptr>::finish(p);
+					}
+					return putl::batch_step<tree_ptr>::follow(key < p->key ? p->left : p->right);
+				});
+		});
+		char name[64];
+		std::snprintf(name, sizeof(name), "tree batch_lookup<%zu>", Width);
+		bench::report(name, queries.size(), seconds);
+		bench::do_not_optimize(checksum(results));
+	}
+
+	void bench_hash_table(std::vector<std::uint64_t> const& keys, std::vector<std::uint64_t> const& queries) {
+		// Four keys per bucket on average.
+		std::vector<chain_ptr> heads(std::max<std::size_t>(keys.size() / 4, 1), chain_ptr{nullptr, 0});
+		std::vector<ChainNode> nodes(keys.size(), ChainNode{0, {nullptr, 0}, 0});
+		std::vector<std::size_t> order(keys.size());
+		for (std::size_t i = 0; i < order.size(); ++i) {
+			order[i] = i;
+		}
+		// Scatter the nodes of each chain over the whole allocation.
+		std::shuffle(order.begin(), order.end(), std::mt19937_64{7});
+		for (std::size_t i = 0; i < keys.size(); ++i) {
+			auto& node = nodes[order[i]];
+			auto& head = heads[keys[i] % heads.size()];
+			node = ChainNode{keys[i], head, keys[i] >> 3};
+			head = {&node, keys[i] % 2};
+		}
+
+		std::vector<chain_ptr> results(queries.size(), chain_ptr{nullptr, 0});
+		auto const seconds = bench::time_it([&] {
+			for (std::size_t i = 0; i < queries.size(); ++i) {
+				auto p = heads[queries[i] % heads.size()];
+				while (p && p->key != queries[i]) {
+					p = p->next;
+				}
+				results[i] = p;
+			}
+		});
+		bench::report("hash chains sequential", queries.size(), seconds);
+		bench::do_not_optimize(checksum(results));
+		bench_chains<1>(heads, queries, results);
+		bench_chains<2>(heads, queries, results);
+		bench_chains<4>(heads, queries, results);
+		bench_chains<8>(heads, queries, results);
+		bench_chains<16>(heads, queries, results);
+		bench_chains<32>(heads, queries, results);
+		bench_chains<64>(heads, queries, results);
+	}
+
+	void bench_trees(std::vector<std::uint64_t> const& keys, std::vector<std::uint64_t> const& queries) {
+		std::vector<TreeNode> nodes(keys.size(), TreeNode{0, {nullptr, 0}, {nullptr, 0}, 0});
+		for (std::size_t i = 0; i < keys.size(); ++i) {
+			nodes[i].key   = keys[i];
+			nodes[i].value = keys[i] >> 3;
+			if (i == 0) {
+				continue;
+			}
+			for (auto parent = &nodes[0];;) {
+				auto& link = keys[i] < parent->key ? parent->left : parent->right;
+				if (!link) {
+					link = {&nodes[i], keys[i] % 2};
+					break;
+				}
+				parent = link.get_ptr();
+			}
+		}
+		tree_ptr const root{nodes.data(), 0};
+
+		std::vector<tree_ptr> results(queries.size(), tree_ptr{nullptr, 0});
+		auto const seconds = bench::time_it([&] {
+			for (std::size_t i = 0; i < queries.size(); ++i) {
+				auto p = root;
+				while (p && p->key != queries[i]) {
+					p = queries[i] < p->key ? p->left : p->right;
+				}
+				results[i] = p;
+			}
+		});
+		bench::report("tree sequential", queries.size(), seconds);
+		bench::do_not_optimize(checksum(results));
+		bench_tree<1>(root, queries, results);
+		bench_tree<2>(root, queries, results);
+		bench_tree<4>(root, queries, results);
+		bench_tree<8>(root, queries, results);
+		bench_tree<16>(root, queries, results);
+		bench_tree<32>(root, queries, results);
+		bench_tree<64>(root, queries, results);
+	}
+}
+
+int main(int argc, char** argv) {
+	auto const count = std::max<std::size_t>(bench::size_arg(argc, argv, 1000000), 1);
+	std::mt19937_64 rng{42};
+	std::vector<std::uint64_t> keys(count);
+	for (auto& key : keys) {
+		key = rng();
+	}
+	// Every query hits, in an order unrelated to the insertion order.
+	auto queries = keys;
+	std::shuffle(queries.begin(), queries.end(), rng);
+	bench_hash_table(keys, queries);
+	bench_trees(keys, queries);
+}
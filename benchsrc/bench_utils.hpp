@@ -0,0 +1,90 @@
+#ifndef POINTER_UTILS_BENCH_UTILS_HPP
+#define POINTER_UTILS_BENCH_UTILS_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/// \brief Keeps the annotated function out-of-line, e.g. to inspect its calling convention.
+#if defined(__GNUC__) || defined(__clang__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE
+#endif
+
+namespace bench {
+	/// \brief Prevents the compiler from optimizing away the computation of `value`.
+	template<typename T>
+	inline void do_not_optimize(T const& value) {
+		asm volatile("" : : "r,m"(value) : "memory");
+	}
+
+	/// \brief Measures the wall-clock time since its construction.
+	class stopwatch {
+	public:
+		stopwatch() : m_start{std::chrono::steady_clock::now()} {}
+
+		/// \brief Returns the elapsed time in seconds.
+		auto elapsed() const -> double {
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point m_start;
+	};
+
+	/// \brief Runs `f` once and returns the elapsed wall-clock time in seconds.
+	template<typename F>
+	auto time_it(F&& f) -> double {
+		stopwatch watch;
+		f();
+		return watch.elapsed();
+	}
+
+	/// \brief Returns the first command line argument as a count or `fallback` if there is none.
+	///
+	/// All benchmarks accept their problem size as first argument so that they
+	/// can be run with tiny sizes as smoke tests.
+	inline auto size_arg(int argc, char** argv, std::size_t fallback) -> std::size_t {
+		return argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : fallback;
+	}
+
+	/// \brief Prints a single benchmark result line.
+	inline void report(char const* name, std::size_t ops, double seconds) {
+		std::printf("%-40s %12.2f Mops/s %10.3f ns/op\n",
+			name,
+			static_cast<double>(ops) / seconds / 1e6,
+			seconds * 1e9 / static_cast<double>(ops));
+	}
+
+	/// \brief Generates a trace of `count` keys in `[0, n)` following a Zipfian
+	///        distribution with the given skew.
+	inline auto zipf_trace(std::size_t n, double skew, std::size_t count, std::uint64_t seed = 42)
+		-> std::vector<std::uint64_t>
+	{
+		std::vector<double> cdf(n);
+		double sum = 0.0;
+		for (std::size_t i = 0; i < n; ++i) {
+			sum += 1.0 / std::pow(static_cast<double>(i + 1), skew);
+			cdf[i] = sum;
+		}
+		std::mt19937_64 rng{seed};
+		std::uniform_real_distribution<double> dist{0.0, sum};
+		std::vector<std::uint64_t> trace(count);
+		for (auto& key : trace) {
+			auto const it = std::lower_bound(cdf.begin(), cdf.end(), dist(rng));
+			key = static_cast<std::uint64_t>(it - cdf.begin());
+		}
+		return trace;
+	}
+}
+
+#endif // POINTER_UTILS_BENCH_UTILS_HPP
@@ -0,0 +1,125 @@
+#include "bench_utils.hpp"
+
+#include <putl/clock_cache.hpp>
+
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+/// \brief Classic LRU cache based on a doubly-linked list as baseline.
+class lru_cache {
+public:
+	explicit lru_cache(std::size_t capacity) : m_capacity{capacity} {}
+
+	auto find(std::uint64_t key) -> std::uint64_t* {
+		auto const it = m_index.find(key);
+		if (it == m_index.end()) {
+			return nullptr;
+		}
+		m_list.splice(m_list.begin(), m_list, it->second);
+		return &it->second->second;
+	}
+
+	void insert(std::uint64_t key, std::uint64_t value) {
+		if (m_list.size() == m_capacity) {
+			m_index.erase(m_list.back().first);
+			m_list.pop_back();
+		}
+		m_list.emplace_front(key, value);
+		m_index.emplace(key, m_list.begin());
+	}
+
+private:
+	using list_type = std::list<std::pair<std::uint64_t, std::uint64_t>>;
+
+	std::size_t                                             m_capacity;
+	list_type                                               m_list;
+	std::unordered_map<std::uint64_t, list_type::iterator> m_index;
+};
+
+template<typename Cache>
+void run_single(char const* name, Cache& cache, std::vector<std::uint64_t> const& trace) {
+	std::size_t hits = 0;
+	auto const seconds = bench::time_it([&] {
+		for (auto key : trace) {
+			if (auto value = cache.find(key)) {
+				bench::do_not_optimize(*value);
+				++hits;
+			}
+			else {
+				cache.insert(key, key);
+			}
+		}
+	});
+	bench::report(name, trace.size(), seconds);
+	std::printf("%-40s %12.2f %%\n", "  hit rate", 100.0 * static_cast<double>(hits) / static_cast<double>(trace.size()));
+}
+
+template<typename Find, typename Insert>
+void run_threaded(char const* name, std::size_t threads, std::vector<std::uint64_t> const& trace, Find find, Insert insert) {
+	auto const seconds = bench::time_it([&] {
+		std::vector<std::thread> workers;
+		for (std::size_t t = 0; t < threads; ++t) {
+			workers.emplace_back([&, t] {
+				for (std::size_t i = t; i < trace.size(); i += threads) {
+					if (!find(trace[i])) {
+						insert(trace[i]);
+					}
+				}
+			});
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	});
+	bench::report(name, trace.size(), seconds);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	auto const ops      = bench::size_arg(argc, argv, 10000000);
+	auto const keys     = std::size_t{1} << 20;
+	auto const capacity = keys / 16;
+	auto const threads  = std::max(2u, std::thread::hardware_concurrency());
+
+	for (auto skew : {0.8, 0.99, 1.2}) {
+		std::printf("zipf skew %.2f, %zu keys, capacity %zu\n", skew, keys, capacity);
+		auto const trace = bench::zipf_trace(keys, skew, ops);
+		{
+			lru_cache cache{capacity};
+			run_single("lru_cache", cache, trace);
+		}
+		{
+			putl::clock_cache<std::uint64_t, std::uint64_t> cache{capacity};
+			run_single("clock_cache", cache, trace);
+		}
+		{
+			lru_cache  cache{capacity};
+			std::mutex mutex;
+			run_threaded("lru_cache + mutex (threaded)", threads, trace,
+				[&](std::uint64_t key) {
+					std::lock_guard<std::mutex> lock{mutex};
+					return cache.find(key) != nullptr;
+				},
+				[&](std::uint64_t key) {
+					std::lock_guard<std::mutex> lock{mutex};
+					cache.insert(key, key);
+				});
+		}
+		{
+			putl::concurrent_clock_cache<std::uint64_t, std::uint64_t> cache{capacity, 4 * threads};
+			run_threaded("concurrent_clock_cache (threaded)", threads, trace,
+				[&](std::uint64_t key) {
+					std::uint64_t value;
+					return cache.find(key, value);
+				},
+				[&](std::uint64_t key) {
+					cache.insert(key, key);
+				});
+		}
+	}
+}
@@ -0,0 +1,60 @@
+# Measures the time to compile the header-heavy state_ptr_instantiations.cpp
+# translation unit for several numbers of instantiated state_ptr types.
+#
+# Usage:
+#   cmake -DCXX=<compiler> -DINCLUDE_DIR=<dir> -DSOURCE=<file>
+#         [-DCOUNTS=<n;...>] [-DREPETITIONS=<n>] -P measure_compile_time.cmake
+#
+# Every configuration is compiled REPETITIONS times with -fsyntax-only and the
+# fastest run is reported, once with the state bits deduced by state_ptr and
+# once each with explicit state bits computed by the builtin-backed log2 and
+# by the former division loop.
+
+if(NOT DEFINED COUNTS)
+	set(COUNTS 250 500 1000 2000)
+endif()
+if(NOT DEFINED REPETITIONS)
+	set(REPETITIONS 3)
+endif()
+if(CMAKE_VERSION VERSION_LESS 3.23)
+	message(WARNING "CMake < 3.23 cannot measure sub-second timestamps, results are in whole seconds.")
+endif()
+
+# Returns the current time in microseconds.
+function(now_us out)
+	if(CMAKE_VERSION VERSION_LESS 3.23)
+		string(TIMESTAMP seconds "%s" UTC)
+		math(EXPR us "${seconds} * 1000000")
+	else()
+		string(TIMESTAMP us "%s%f" UTC)
+	endif()
+	set(${out} ${us} PARENT_SCOPE)
+endfunction()
+
+foreach(count IN LISTS COUNTS)
+	foreach(variant default builtin loop)
+		set(defines -DSTATE_PTR_BENCH_TYPES=${count})
+		if(variant STREQUAL "builtin")
+			list(APPEND defines -DSTATE_PTR_BENCH_BUILTIN_LOG2)
+		elseif(variant STREQUAL "loop")
+			list(APPEND defines -DSTATE_PTR_BENCH_LOOP_LOG2)
+		endif()
+		set(best "")
+		foreach(rep RANGE 1 ${REPETITIONS})
+			now_us(start)
+			execute_process(
+				COMMAND ${CXX} -std=c++14 -fsyntax-only -I${INCLUDE_DIR} ${defines} ${SOURCE}
+				RESULT_VARIABLE result
+			)
+			now_us(stop)
+			if(NOT result EQUAL 0)
+				message(FATAL_ERROR "Compiling ${SOURCE} with ${count} types (${variant}) failed.")
+			endif()
+			math(EXPR elapsed "(${stop} - ${start}) / 1000")
+			if(best STREQUAL "" OR elapsed LESS best)
+				set(best ${elapsed})
+			endif()
+		endforeach()
+		message("state_ptr instantiations ${count} (${variant}): ${best} ms")
+	endforeach()
+endforeach()
@@ -0,0 +1,70 @@
+// Header-heavy translation unit measuring the compile-time cost of state_ptr
+// instantiations. It includes all pointer utils and instantiates
+// STATE_PTR_BENCH_TYPES distinct state_ptr types, each deriving its default
+// number of state bits from the alignment of its element type.
+//
+// By default state_ptr deduces the state bits itself. With
+// STATE_PTR_BENCH_BUILTIN_LOG2 or STATE_PTR_BENCH_LOOP_LOG2 defined they are
+// passed explicitly, computed by detail::log2 or by the former division loop.
+
+#include <putl/atomic_state_ptr.hpp>
+#include <putl/high_state_ptr.hpp>
+#include <putl/packed48_vector.hpp>
+#include <putl/radix_sort.hpp>
+#include <putl/sorted_state_ptr_array.hpp>
+#include <putl/state_index.hpp>
+#include <putl/state_ptr.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#ifndef STATE_PTR_BENCH_TYPES
+#define STATE_PTR_BENCH_TYPES 1000
+#endif
+
+namespace {
+	/// \brief Returns the alignment of the element type with the given index.
+	constexpr auto bench_alignment(std::size_t index) -> std::size_t {
+		return std::size_t{1} << (index % 8);
+	}
+
+	/// \brief A distinct element type per index with varying alignment.
+	template<std::size_t I>
+	struct alignas(bench_alignment(I)) tagged {
+		unsigned char payload[bench_alignment(I)];
+	};
+
+#if defined(STATE_PTR_BENCH_LOOP_LOG2)
+	template<typename T>
+	constexpr auto loop_log2(T number) -> T {
+		T acc{0};
+		while (number > 1) {
+			number /= 2;
+			acc += 1;
+		}
+		return acc;
+	}
+
+	template<std::size_t I>
+	using bench_ptr = putl::state_ptr<tagged<I>, std::uintptr_t, loop_log2(alignof(tagged<I>))>;
+#elif defined(STATE_PTR_BENCH_BUILTIN_LOG2)
+	template<std::size_t I>
+	using bench_ptr = putl::state_ptr<tagged<I>, std::uintptr_t, putl::detail::log2(alignof(tagged<I>))>;
+#else
+	template<std::size_t I>
+	using bench_ptr = putl::state_ptr<tagged<I>>;
+#endif
+
+	template<std::size_t... Is>
+	auto instantiate(std::index_sequence<Is...>) -> std::size_t {
+		std::size_t sum = 0;
+		int expand[] = {0, (sum += sizeof(bench_ptr<Is>) + bench_ptr<Is>{nullptr, 0}.get_state(), 0)...};
+		static_cast<void>(expand);
+		return sum;
+	}
+}
+
+auto state_ptr_instantiations() -> std::size_t {
+	return instantiate(std::make_index_sequence<STATE_PTR_BENCH_TYPES>{});
+}
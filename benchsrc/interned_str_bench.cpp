@@ -0,0 +1,75 @@
+#include "bench_utils.hpp"
+
+#include <putl/interned_str.hpp>
+
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+/// \brief Generates a symbol-heavy trace of identifiers with Zipfian frequencies.
+auto symbol_trace(std::size_t count) -> std::vector<std::string> {
+	auto const keys = bench::zipf_trace(1 << 16, 1.0, count);
+	std::vector<std::string> symbols;
+	symbols.reserve(count);
+	for (auto key : keys) {
+		symbols.push_back("namespace::module::symbol_" + std::to_string(key));
+	}
+	return symbols;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	auto const count   = bench::size_arg(argc, argv, 2000000);
+	auto const symbols = symbol_trace(count);
+
+	putl::interner strings;
+	std::vector<putl::interned_str> handles;
+	handles.reserve(count);
+	auto const intern_seconds = bench::time_it([&] {
+		for (auto const& s : symbols) {
+			handles.push_back(strings.intern(s));
+		}
+	});
+	bench::report("interner::intern", count, intern_seconds);
+
+	{
+		std::unordered_map<std::string, std::size_t> table;
+		auto const seconds = bench::time_it([&] {
+			for (auto const& s : symbols) {
+				++table[s];
+			}
+		});
+		bench::report("unordered_map<std::string> count", count, seconds);
+	}
+	{
+		std::unordered_map<putl::interned_str, std::size_t> table;
+		auto const seconds = bench::time_it([&] {
+			for (auto const& s : handles) {
+				++table[s];
+			}
+		});
+		bench::report("unordered_map<interned_str> count", count, seconds);
+	}
+	{
+		std::size_t equal = 0;
+		auto const seconds = bench::time_it([&] {
+			for (std::size_t i = 1; i < symbols.size(); ++i) {
+				equal += symbols[i] == symbols[i - 1];
+			}
+		});
+		bench::do_not_optimize(equal);
+		bench::report("std::string operator==", count, seconds);
+	}
+	{
+		std::size_t equal = 0;
+		auto const seconds = bench::time_it([&] {
+			for (std::size_t i = 1; i < handles.size(); ++i) {
+				equal += handles[i] == handles[i - 1];
+			}
+		});
+		bench::do_not_optimize(equal);
+		bench::report("interned_str operator==", count, seconds);
+	}
+}
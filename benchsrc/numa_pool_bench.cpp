@@ -0,0 +1,67 @@
+#include "bench_utils.hpp"
+
+#include <putl/numa_pool.hpp>
+
+#include <thread>
+
+namespace {
+
+struct Object {
+	std::uint64_t payload[6];
+};
+
+/// \brief Every thread allocates a batch on its own (simulated) node and then
+///        frees the batch that its neighbour thread allocated on another node.
+template<typename Alloc, typename Free>
+void run(char const* name, std::size_t threads, std::size_t batch, std::size_t rounds, Alloc alloc, Free free) {
+	using ptr_type = decltype(alloc(std::size_t{0}));
+	std::vector<std::vector<ptr_type>> batches(threads);
+	auto const seconds = bench::time_it([&] {
+		for (std::size_t r = 0; r < rounds; ++r) {
+			std::vector<std::thread> workers;
+			for (std::size_t t = 0; t < threads; ++t) {
+				workers.emplace_back([&, t] {
+					auto& own = batches[t];
+					own.clear();
+					for (std::size_t i = 0; i < batch; ++i) {
+						own.push_back(alloc(t));
+					}
+				});
+			}
+			for (auto& worker : workers) {
+				worker.join();
+			}
+			workers.clear();
+			for (std::size_t t = 0; t < threads; ++t) {
+				workers.emplace_back([&, t] {
+					for (auto p : batches[(t + 1) % threads]) {
+						free(p);
+					}
+				});
+			}
+			for (auto& worker : workers) {
+				worker.join();
+			}
+		}
+	});
+	bench::report(name, 2 * threads * batch * rounds, seconds);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	auto const batch   = bench::size_arg(argc, argv, 100000);
+	auto const rounds  = std::size_t{20};
+	auto const nodes   = std::size_t{4};
+	auto const threads = nodes;
+
+	std::printf("%zu (simulated) nodes, %zu detected\n", nodes, putl::detail::numa_node_count());
+	run("global new/delete", threads, batch, rounds,
+		[](std::size_t) { return new Object{}; },
+		[](Object* p) { delete p; });
+
+	putl::numa_pool<Object> pool{nodes};
+	run("numa_pool (remote frees)", threads, batch, rounds,
+		[&](std::size_t node) { return pool.allocate(node % nodes); },
+		[&](putl::numa_pool<Object>::pointer p) { pool.deallocate(p); });
+}
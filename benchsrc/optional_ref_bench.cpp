@@ -0,0 +1,88 @@
+#include "bench_utils.hpp"
+
+#include <putl/optional_ref.hpp>
+
+#if __cplusplus >= 201703L
+#include <optional>
+#endif
+
+namespace {
+
+struct Entry {
+	std::uint64_t key;
+	std::uint64_t value;
+};
+
+// The find_* functions are kept out-of-line so that their calling convention can
+// be compared: optional_ref is returned in a single register while std::optional<T*>
+// is returned in two registers (or memory) and T** requires an out-parameter.
+// Inspect them with e.g. `objdump -d --no-show-raw-insn optional_ref_bench`.
+// The codegen test testsrc/codegen/optional_ref_probes.cpp checks that
+// optional_ref costs the same as a raw pointer.
+
+BENCH_NOINLINE
+auto find_optional_ref(std::vector<Entry>& entries, std::uint64_t key) -> putl::optional_ref<Entry> {
+	auto const i = key % (entries.size() + entries.size() / 4);
+	if (i >= entries.size()) {
+		return {};
+	}
+	return &entries[i];
+}
+
+#if __cplusplus >= 201703L
+BENCH_NOINLINE
+auto find_std_optional(std::vector<Entry>& entries, std::uint64_t key) -> std::optional<Entry*> {
+	auto const i = key % (entries.size() + entries.size() / 4);
+	if (i >= entries.size()) {
+		return std::nullopt;
+	}
+	return &entries[i];
+}
+#endif
+
+BENCH_NOINLINE
+auto find_out_param(std::vector<Entry>& entries, std::uint64_t key, Entry** out) -> bool {
+	auto const i = key % (entries.size() + entries.size() / 4);
+	if (i >= entries.size()) {
+		return false;
+	}
+	*out = &entries[i];
+	return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	auto const ops = bench::size_arg(argc, argv, 50000000);
+	std::vector<Entry> entries(1024);
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		entries[i] = Entry{i, i * i};
+	}
+
+	std::uint64_t sum = 0;
+	bench::report("putl::optional_ref<T>", ops, bench::time_it([&] {
+		for (std::uint64_t k = 0; k < ops; ++k) {
+			if (auto r = find_optional_ref(entries, k)) {
+				sum += r.value()->value;
+			}
+		}
+	}));
+#if __cplusplus >= 201703L
+	bench::report("std::optional<T*>", ops, bench::time_it([&] {
+		for (std::uint64_t k = 0; k < ops; ++k) {
+			if (auto r = find_std_optional(entries, k)) {
+				sum += (*r)->value;
+			}
+		}
+	}));
+#endif
+	bench::report("bool + T** out-parameter", ops, bench::time_it([&] {
+		for (std::uint64_t k = 0; k < ops; ++k) {
+			Entry* r;
+			if (find_out_param(entries, k, &r)) {
+				sum += r->value;
+			}
+		}
+	}));
+	bench::do_not_optimize(sum);
+}
@@ -0,0 +1,48 @@
+#include "bench_utils.hpp"
+
+#include <putl/packed48_vector.hpp>
+
+int main(int argc, char** argv) {
+	auto const count  = bench::size_arg(argc, argv, 20000000);
+	auto const rounds = std::size_t{10};
+	std::vector<std::uint64_t> targets(1024);
+
+	std::vector<putl::state_ptr<std::uint64_t>> plain;
+	putl::packed48_vector<std::uint64_t> packed;
+	plain.reserve(count);
+	packed.reserve(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		putl::state_ptr<std::uint64_t> p{&targets[(i * 7919) % targets.size()], i % 8};
+		plain.push_back(p);
+		packed.push_back(p);
+	}
+	std::printf("%-40s %12.1f MiB\n", "std::vector<state_ptr<T>> memory",
+		static_cast<double>(plain.capacity() * sizeof(plain[0])) / (1 << 20));
+	std::printf("%-40s %12.1f MiB\n", "packed48_vector<T> memory",
+		static_cast<double>(packed.memory_bytes()) / (1 << 20));
+
+	std::uintptr_t acc = 0;
+	bench::report("std::vector<state_ptr<T>> scan", count * rounds, bench::time_it([&] {
+		for (std::size_t r = 0; r < rounds; ++r) {
+			for (auto const& p : plain) {
+				acc += reinterpret_cast<std::uintptr_t>(p.get_ptr()) ^ p.get_state();
+			}
+		}
+	}));
+	bench::report("packed48_vector<T> for_each scan", count * rounds, bench::time_it([&] {
+		for (std::size_t r = 0; r < rounds; ++r) {
+			packed.for_each([&](putl::state_ptr<std::uint64_t> const& p) {
+				acc += reinterpret_cast<std::uintptr_t>(p.get_ptr()) ^ p.get_state();
+			});
+		}
+	}));
+	bench::report("packed48_vector<T> random access scan", count * rounds, bench::time_it([&] {
+		for (std::size_t r = 0; r < rounds; ++r) {
+			for (std::size_t i = 0; i < packed.size(); ++i) {
+				auto const p = packed[i];
+				acc += reinterpret_cast<std::uintptr_t>(p.get_ptr()) ^ p.get_state();
+			}
+		}
+	}));
+	bench::do_not_optimize(acc);
+}
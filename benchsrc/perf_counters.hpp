@@ -0,0 +1,241 @@
+#ifndef POINTER_UTILS_BENCH_PERF_COUNTERS_HPP
+#define POINTER_UTILS_BENCH_PERF_COUNTERS_HPP
+
+#include "bench_utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+	/// \brief The hardware events measured by perf_counters.
+	enum class perf_event {
+		l1d_misses,
+		llc_misses,
+		dtlb_misses,
+		branch_misses
+	};
+
+	/// \brief Measures hardware events of the calling thread with Linux perf_event_open.
+	///
+	/// Every event is opened on its own so that events the CPU or the kernel do
+	/// not provide are merely reported as unavailable. In containers without
+	/// access to perf events, e.g. due to `perf_event_paranoid` or seccomp,
+	/// all events are unavailable and only wall-clock times are reported.
+	/// Counts are scaled when the kernel multiplexes events.
+	class perf_counters {
+	public:
+		/// \brief The number of measured events.
+		constexpr static std::size_t event_count = 4;
+
+		perf_counters();
+		~perf_counters();
+
+		perf_counters(perf_counters const&) = delete;
+		auto operator=(perf_counters const&) -> perf_counters& = delete;
+
+		/// \brief Resets and starts all available counters.
+		void start() noexcept;
+
+		/// \brief Stops all available counters and reads their values.
+		void stop() noexcept;
+
+		/// \brief Returns `true` if the given event is measured.
+		auto available(perf_event event) const noexcept -> bool;
+
+		/// \brief Returns `true` if the given event was counted between the last
+		///        start and stop.
+		///
+		/// Available events may still not be counted when the kernel never
+		/// scheduled them, e.g. because other events occupied the counters.
+		auto valid(perf_event event) const noexcept -> bool;
+
+		/// \brief Returns `true` if any event is measured.
+		auto any_available() const noexcept -> bool;
+
+		/// \brief Returns the count of the given event between the last start and stop.
+		auto value(perf_event event) const noexcept -> double;
+
+		/// \brief Returns a short name of the given event.
+		static auto name(perf_event event) noexcept -> char const*;
+
+	private:
+		int    m_fds[event_count];
+		double m_values[event_count];
+		bool   m_valid[event_count];
+	};
+
+	/// \brief Prints a single benchmark result line with per-operation event counts.
+	///
+	/// Unavailable events and events that were not counted are printed as `n/a`.
+	inline void report(char const* name, std::size_t ops, double seconds, perf_counters const& counters) {
+		std::printf("%-40s %12.2f Mops/s %10.3f ns/op",
+			name,
+			static_cast<double>(ops) / seconds / 1e6,
+			seconds * 1e9 / static_cast<double>(ops));
+		for (std::size_t i = 0; i < perf_counters::event_count; ++i) {
+			auto const event = static_cast<perf_event>(i);
+			if (counters.valid(event)) {
+				std::printf(" %8.3f %s/op", counters.value(event) / static_cast<double>(ops), perf_counters::name(event));
+			}
+			else {
+				std::printf(" %8s %s/op", "n/a", perf_counters::name(event));
+			}
+		}
+		std::printf("\n");
+	}
+
+	/// \brief Runs `f` once while measuring the given counters and returns
+	///        the elapsed wall-clock time in seconds.
+	template<typename F>
+	auto time_it(F&& f, perf_counters& counters) -> double {
+		counters.start();
+		stopwatch watch;
+		f();
+		auto const seconds = watch.elapsed();
+		counters.stop();
+		return seconds;
+	}
+
+	/// =======================================================================
+	///  Implementation of perf_counters.
+	/// =======================================================================
+
+#if defined(__linux__)
+	namespace detail {
+		inline auto perf_event_config(perf_event event) noexcept -> perf_event_attr {
+			perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.size           = sizeof(attr);
+			attr.disabled       = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv     = 1;
+			attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			auto const cache_miss = [](std::uint64_t cache) -> std::uint64_t {
+				return cache
+					| (std::uint64_t{PERF_COUNT_HW_CACHE_OP_READ} << 8)
+					| (std::uint64_t{PERF_COUNT_HW_CACHE_RESULT_MISS} << 16);
+			};
+			switch (event) {
+				case perf_event::l1d_misses:
+					attr.type   = PERF_TYPE_HW_CACHE;
+					attr.config = cache_miss(PERF_COUNT_HW_CACHE_L1D);
+					break;
+				case perf_event::llc_misses:
+					attr.type   = PERF_TYPE_HW_CACHE;
+					attr.config = cache_miss(PERF_COUNT_HW_CACHE_LL);
+					break;
+				case perf_event::dtlb_misses:
+					attr.type   = PERF_TYPE_HW_CACHE;
+					attr.config = cache_miss(PERF_COUNT_HW_CACHE_DTLB);
+					break;
+				case perf_event::branch_misses:
+					attr.type   = PERF_TYPE_HARDWARE;
+					attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+					break;
+			}
+			return attr;
+		}
+	}
+
+	inline perf_counters::perf_counters() {
+		for (std::size_t i = 0; i < event_count; ++i) {
+			auto attr = detail::perf_event_config(static_cast<perf_event>(i));
+			m_fds[i]    = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+			m_values[i] = 0.0;
+			m_valid[i]  = false;
+		}
+	}
+
+	inline perf_counters::~perf_counters() {
+		for (auto const fd : m_fds) {
+			if (fd >= 0) {
+				close(fd);
+			}
+		}
+	}
+
+	inline void perf_counters::start() noexcept {
+		for (auto const fd : m_fds) {
+			if (fd >= 0) {
+				ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+		}
+	}
+
+	inline void perf_counters::stop() noexcept {
+		for (std::size_t i = 0; i < event_count; ++i) {
+			m_values[i] = 0.0;
+			m_valid[i]  = false;
+			if (m_fds[i] < 0) {
+				continue;
+			}
+			ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+			// value, time enabled, time running
+			std::uint64_t data[3] = {0, 0, 0};
+			if (read(m_fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+				// Never scheduled, e.g. multiplexed out for the whole run.
+				continue;
+			}
+			m_values[i] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+			m_valid[i]  = true;
+		}
+	}
+#else
+	inline perf_counters::perf_counters() {
+		for (std::size_t i = 0; i < event_count; ++i) {
+			m_fds[i]    = -1;
+			m_values[i] = 0.0;
+			m_valid[i]  = false;
+		}
+	}
+
+	inline perf_counters::~perf_counters() {}
+
+	inline void perf_counters::start() noexcept {}
+
+	inline void perf_counters::stop() noexcept {}
+#endif
+
+	inline auto perf_counters::available(perf_event event) const noexcept -> bool {
+		return m_fds[static_cast<std::size_t>(event)] >= 0;
+	}
+
+	inline auto perf_counters::valid(perf_event event) const noexcept -> bool {
+		return m_valid[static_cast<std::size_t>(event)];
+	}
+
+	inline auto perf_counters::any_available() const noexcept -> bool {
+		for (auto const fd : m_fds) {
+			if (fd >= 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	inline auto perf_counters::value(perf_event event) const noexcept -> double {
+		return m_values[static_cast<std::size_t>(event)];
+	}
+
+	inline auto perf_counters::name(perf_event event) noexcept -> char const* {
+		switch (event) {
+			case perf_event::l1d_misses:    return "L1D";
+			case perf_event::llc_misses:    return "LLC";
+			case perf_event::dtlb_misses:   return "dTLB";
+			case perf_event::branch_misses: return "br";
+		}
+		return "?";
+	}
+}
+
+#endif // POINTER_UTILS_BENCH_PERF_COUNTERS_HPP
@@ -0,0 +1,164 @@
+#include "bench_utils.hpp"
+#include "perf_counters.hpp"
+
+#include <putl/prefetch.hpp>
+#include <putl/state_ptr.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Compares traversals of randomly linked lists and trees with and without
+// software prefetching through state_ptr::prefetch and putl::prefetch_chain.
+//
+// The node count defaults to 1e6. Counts up to 1e9 are supported but require
+// 64 GB of memory for the lists alone, run the list and tree sizes separately
+// by passing the count as first argument.
+//
+// The nodes are cache line aligned, which std::vector only guarantees with the
+// aligned allocation of C++17.
+
+#if !defined(__cpp_aligned_new)
+#error "prefetch_bench requires aligned allocation, compile it as C++17."
+#endif
+
+namespace {
+	/// \brief A list node filling a cache line, with a mark bit in its link.
+	struct alignas(64) ListNode {
+		putl::state_ptr<ListNode, std::uintptr_t, 1> next;
+		std::uint64_t                                payload[7];
+	};
+
+	/// \brief A binary search tree node filling a cache line, with its color in the left link.
+	struct alignas(64) TreeNode {
+		std::uint64_t                                key;
+		putl::state_ptr<TreeNode, std::uintptr_t, 1> left;
+		putl::state_ptr<TreeNode, std::uintptr_t, 1> right;
+		std::uint64_t                                payload[5];
+	};
+
+	using list_ptr = putl::state_ptr<ListNode, std::uintptr_t, 1>;
+
+	auto next_link(list_ptr p) -> list_ptr {
+		return p->next;
+	}
+
+	/// \brief Simulates computation on a visited node which the prefetches can overlap with.
+	auto work(ListNode const& node, unsigned rounds) -> std::uint64_t {
+		auto h = node.payload[0];
+		for (unsigned i = 0; i < rounds; ++i) {
+			h = (h ^ (h >> 29)) * 0xbf58476d1ce4e5b9u + node.payload[i % 7];
+		}
+		return h;
+	}
+
+	auto visit_naive(list_ptr head, unsigned rounds) -> std::uint64_t {
+		std::uint64_t sum = 0;
+		for (auto p = head; p; p = p->next) {
+			sum += p->next.get_state() != 0 ? work(*p, rounds) : 0;
+		}
+		return sum;
+	}
+
+	auto visit_prefetching(list_ptr head, std::size_t distance, unsigned rounds) -> std::uint64_t {
+		std::uint64_t sum = 0;
+		// The runahead cursor stays `distance` links ahead of the visited node.
+		// Each step follows the link it prefetched during the previous step
+		// and prefetches the successor, so that every hint has the work on one
+		// node to complete before its link is followed.
+		auto ahead = putl::prefetch_chain(head, distance, next_link);
+		for (auto p = head; p; p = p->next) {
+			ahead = putl::prefetch_chain(ahead, 1, next_link);
+			sum += p->next.get_state() != 0 ? work(*p, rounds) : 0;
+		}
+		return sum;
+	}
+
+	void bench_lists(std::size_t count, bench::perf_counters& counters) {
+		std::vector<std::size_t> order(count);
+		std::iota(order.begin(), order.end(), std::size_t{0});
+		std::shuffle(order.begin(), order.end(), std::mt19937_64{42});
+		std::vector<ListNode> nodes(count, ListNode{{nullptr, 0}, {}});
+		for (std::size_t i = 0; i < count; ++i) {
+			auto const node = order[i];
+			auto const next = i + 1 < count ? &nodes[order[i + 1]] : nullptr;
+			nodes[node].next = {next, node % 2 == 0 ? 1u : 0u};
+			std::fill(std::begin(nodes[node].payload), std::end(nodes[node].payload), node);
+		}
+		list_ptr const head{&nodes[order[0]], 0};
+
+		char name[64];
+		std::uint64_t sum = 0;
+		for (auto const rounds : {0u, 64u}) {
+			auto seconds = bench::time_it([&] { sum += visit_naive(head, rounds); }, counters);
+			std::snprintf(name, sizeof(name), "list work %u naive", rounds);
+			bench::report(name, count, seconds, counters);
+			for (auto const distance : {std::size_t{2}, std::size_t{4}, std::size_t{8}, std::size_t{16}}) {
+				seconds = bench::time_it([&] { sum += visit_prefetching(head, distance, rounds); }, counters);
+				std::snprintf(name, sizeof(name), "list work %u prefetch_chain k=%zu", rounds, distance);
+				bench::report(name, count, seconds, counters);
+			}
+		}
+		bench::do_not_optimize(sum);
+	}
+
+	void bench_trees(std::size_t count, bench::perf_counters& counters) {
+		std::mt19937_64 rng{42};
+		std::vector<TreeNode>      nodes(count, TreeNode{0, {nullptr, 0}, {nullptr, 0}, {}});
+		std::vector<std::uint64_t> keys(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			keys[i]       = rng();
+			nodes[i].key  = keys[i];
+			nodes[i].left = {nullptr, keys[i] % 2 == 0 ? 1u : 0u};
+			if (i == 0) {
+				continue;
+			}
+			for (auto parent = &nodes[0];;) {
+				auto& link = keys[i] < parent->key ? parent->left : parent->right;
+				if (link.get_ptr() == nullptr) {
+					link = {&nodes[i], link.get_state()};
+					break;
+				}
+				parent = link.get_ptr();
+			}
+		}
+		std::shuffle(keys.begin(), keys.end(), rng);
+
+		std::uint64_t reds = 0;
+		auto seconds = bench::time_it([&] {
+			for (auto const key : keys) {
+				for (auto node = &nodes[0]; node != nullptr && node->key != key;) {
+					reds += node->left.get_state();
+					node = key < node->key ? node->left.get_ptr() : node->right.get_ptr();
+				}
+			}
+		}, counters);
+		bench::report("tree lookup naive", count, seconds, counters);
+		seconds = bench::time_it([&] {
+			for (auto const key : keys) {
+				for (auto node = &nodes[0]; node != nullptr && node->key != key;) {
+					// Both children are requested before the comparison selects one.
+					node->left.prefetch();
+					node->right.prefetch();
+					reds += node->left.get_state();
+					node = key < node->key ? node->left.get_ptr() : node->right.get_ptr();
+				}
+			}
+		}, counters);
+		bench::report("tree lookup prefetch children", count, seconds, counters);
+		bench::do_not_optimize(reds);
+	}
+}
+
+int main(int argc, char** argv) {
+	auto const count = bench::size_arg(argc, argv, 1000000);
+	bench::perf_counters counters;
+	if (!counters.any_available()) {
+		std::printf("perf events are unavailable, reporting wall-clock times only\n");
+	}
+	bench_lists(count, counters);
+	bench_trees(count, counters);
+}
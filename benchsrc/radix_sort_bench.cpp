@@ -0,0 +1,74 @@
+#include "bench_utils.hpp"
+
+#include <putl/radix_sort.hpp>
+
+#include <algorithm>
+#include <random>
+
+namespace {
+	struct alignas(16) Object {
+		std::uint64_t payload[2];
+	};
+
+	using list_type = std::vector<putl::state_ptr<Object>>;
+
+	auto traverse(list_type const& list) -> std::uint64_t {
+		std::uint64_t acc = 0;
+		for (auto const& p : list) {
+			acc += p->payload[p.get_state() & 1];
+		}
+		return acc;
+	}
+}
+
+int main(int argc, char** argv) {
+	auto const count = bench::size_arg(argc, argv, 100000000);
+	std::vector<Object> objects(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		objects[i].payload[0] = i;
+		objects[i].payload[1] = ~i;
+	}
+
+	list_type shuffled;
+	shuffled.reserve(count);
+	std::mt19937_64 rng{42};
+	for (std::size_t i = 0; i < count; ++i) {
+		shuffled.emplace_back(&objects[rng() % count], i % 16);
+	}
+
+	std::uint64_t acc = 0;
+	bench::report("traverse shuffled", count, bench::time_it([&] {
+		acc += traverse(shuffled);
+	}));
+
+	auto list = shuffled;
+	bench::report("std::sort by address", count, bench::time_it([&] {
+		std::sort(list.begin(), list.end(), [](putl::state_ptr<Object> const& lhs, putl::state_ptr<Object> const& rhs) {
+			return lhs.get_ptr() < rhs.get_ptr();
+		});
+	}));
+	list = shuffled;
+	bench::report("sort_by_address", count, bench::time_it([&] {
+		putl::sort_by_address(list.begin(), list.end());
+	}));
+	list = shuffled;
+	bench::report("parallel_sort_by_address", count, bench::time_it([&] {
+		putl::parallel_sort_by_address(list.begin(), list.end());
+	}));
+	bench::report("traverse sorted by address", count, bench::time_it([&] {
+		acc += traverse(list);
+	}));
+
+	list = shuffled;
+	bench::report("bucket_by_state", count, bench::time_it([&] {
+		acc += putl::bucket_by_state(list.begin(), list.end()).back();
+	}));
+	list = shuffled;
+	bench::report("parallel_bucket_by_state", count, bench::time_it([&] {
+		acc += putl::parallel_bucket_by_state(list.begin(), list.end()).back();
+	}));
+	bench::report("traverse bucketed by state", count, bench::time_it([&] {
+		acc += traverse(list);
+	}));
+	bench::do_not_optimize(acc);
+}
@@ -0,0 +1,62 @@
+#include "bench_utils.hpp"
+
+#include <putl/sorted_state_ptr_array.hpp>
+
+#include <algorithm>
+
+namespace {
+	struct alignas(8) Object {
+		std::uint64_t payload[4];
+	};
+}
+
+int main(int argc, char** argv) {
+	auto const count  = bench::size_arg(argc, argv, 10000000);
+	auto const rounds = std::size_t{10};
+	std::vector<Object> objects(count);
+
+	// Work lists hold most but not all objects of an arena in address order.
+	std::vector<putl::state_ptr<Object>> plain;
+	plain.reserve(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		if ((i * 2654435761u) % 8 != 0) {
+			plain.emplace_back(&objects[i], i % 8);
+		}
+	}
+	putl::sorted_state_ptr_array<Object> compressed{plain.begin(), plain.end()};
+	std::printf("%-44s %12.1f MiB\n", "std::vector<state_ptr<T>> memory",
+		static_cast<double>(plain.capacity() * sizeof(plain[0])) / (1 << 20));
+	std::printf("%-44s %12.1f MiB\n", "sorted_state_ptr_array<T> memory",
+		static_cast<double>(compressed.memory_bytes()) / (1 << 20));
+
+	std::uintptr_t acc = 0;
+	bench::report("std::vector<state_ptr<T>> scan", plain.size() * rounds, bench::time_it([&] {
+		for (std::size_t r = 0; r < rounds; ++r) {
+			for (auto const& p : plain) {
+				acc += reinterpret_cast<std::uintptr_t>(p.get_ptr()) ^ p.get_state();
+			}
+		}
+	}));
+	bench::report("sorted_state_ptr_array<T> for_each scan", plain.size() * rounds, bench::time_it([&] {
+		for (std::size_t r = 0; r < rounds; ++r) {
+			compressed.for_each([&](putl::state_ptr<Object> const& p) {
+				acc += reinterpret_cast<std::uintptr_t>(p.get_ptr()) ^ p.get_state();
+			});
+		}
+	}));
+
+	auto const lookups = count;
+	bench::report("std::lower_bound on std::vector", lookups, bench::time_it([&] {
+		for (std::size_t i = 0; i < lookups; ++i) {
+			auto const key = &objects[(i * 7919) % count];
+			acc += static_cast<std::uintptr_t>(std::lower_bound(plain.begin(), plain.end(), key,
+				[](putl::state_ptr<Object> const& p, Object const* k) { return p.get_ptr() < k; }) - plain.begin());
+		}
+	}));
+	bench::report("sorted_state_ptr_array<T>::lower_bound", lookups, bench::time_it([&] {
+		for (std::size_t i = 0; i < lookups; ++i) {
+			acc += compressed.lower_bound(&objects[(i * 7919) % count]);
+		}
+	}));
+	bench::do_not_optimize(acc);
+}
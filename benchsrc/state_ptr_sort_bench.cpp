@@ -0,0 +1,43 @@
+#include "bench_utils.hpp"
+
+#include <putl/state_ptr.hpp>
+
+#include <algorithm>
+#include <random>
+
+namespace {
+	struct alignas(8) Object {
+		std::uint64_t payload;
+	};
+}
+
+int main(int argc, char** argv) {
+	auto const count = bench::size_arg(argc, argv, 10000000);
+	std::vector<Object> objects(count);
+
+	std::vector<putl::state_ptr<Object>> shuffled;
+	std::vector<std::uintptr_t> raw_shuffled;
+	shuffled.reserve(count);
+	raw_shuffled.reserve(count);
+	std::mt19937_64 rng{42};
+	for (std::size_t i = 0; i < count; ++i) {
+		putl::state_ptr<Object> p{&objects[rng() % count], i % 8};
+		shuffled.push_back(p);
+		raw_shuffled.push_back(reinterpret_cast<std::uintptr_t>(p.get_ptr()) | p.get_state());
+	}
+
+	auto raw = raw_shuffled;
+	bench::report("std::sort std::uintptr_t", count, bench::time_it([&] {
+		std::sort(raw.begin(), raw.end());
+	}));
+	auto ptrs = shuffled;
+	bench::report("std::sort state_ptr<T> (operator<)", count, bench::time_it([&] {
+		std::sort(ptrs.begin(), ptrs.end());
+	}));
+	ptrs = shuffled;
+	bench::report("std::sort state_ptr<T> (address_less)", count, bench::time_it([&] {
+		std::sort(ptrs.begin(), ptrs.end(), putl::state_ptr_address_less{});
+	}));
+	bench::do_not_optimize(raw.front());
+	bench::do_not_optimize(ptrs.front());
+}
@@ -0,0 +1,81 @@
+#include "bench_utils.hpp"
+
+#include <putl/transition_telemetry.hpp>
+
+#include <cstdio>
+#include <initializer_list>
+#include <random>
+#include <vector>
+
+namespace {
+	struct alignas(8) Page {
+		std::uint64_t payload[8];
+	};
+
+	struct FullTag {};
+	struct SampledTag {};
+
+	using full_telemetry    = putl::transition_telemetry<2, FullTag>;
+	using sampled_telemetry = putl::transition_telemetry<2, SampledTag, 64>;
+
+	/// \brief Drives the pages through CLEAN -> DIRTY -> WRITEBACK -> CLEAN in
+	///        random order and touches each page as a state machine would.
+	///
+	/// With `checksum` every transition additionally checksums the page which
+	/// models a state machine doing actual work per transition.
+	template<typename Policy>
+	auto run(char const* name, std::vector<Page>& pages, std::vector<std::uint32_t> const& trace, bool checksum) -> double {
+		using page_ptr = putl::state_ptr<Page, std::uintptr_t, 2, Policy>;
+		std::vector<page_ptr> links;
+		links.reserve(pages.size());
+		for (auto& page : pages) {
+			links.emplace_back(&page, 0);
+		}
+		std::uint64_t sum = 0;
+		auto const seconds = bench::time_it([&] {
+			for (auto const index : trace) {
+				auto& link = links[index];
+				auto const state = link.get_state();
+				link.set_state(state == 2 ? 0 : state + 1);
+				if (checksum) {
+					for (auto const word : link->payload) {
+						sum = (sum ^ word) * 0x100000001b3u;
+					}
+				}
+				else {
+					sum += link->payload[state];
+				}
+			}
+		});
+		bench::do_not_optimize(sum);
+		bench::report(name, trace.size(), seconds);
+		return seconds;
+	}
+}
+
+int main(int argc, char** argv) {
+	auto const count = bench::size_arg(argc, argv, 10000000);
+	std::vector<Page> pages(count / 16 + 1);
+	std::vector<std::uint32_t> trace(count);
+	std::mt19937_64 rng{42};
+	for (auto& index : trace) {
+		index = static_cast<std::uint32_t>(rng() % pages.size());
+	}
+
+	for (auto const checksum : {false, true}) {
+		std::printf("%s\n", checksum ? "-- checksum per transition" : "-- touch per transition");
+		auto const base    = run<putl::check_policy::unchecked>("set_state uninstrumented", pages, trace, checksum);
+		auto const full    = run<putl::check_policy::instrumented<full_telemetry, putl::check_policy::unchecked>>(
+			"set_state with telemetry", pages, trace, checksum);
+		auto const sampled = run<putl::check_policy::instrumented<sampled_telemetry, putl::check_policy::unchecked>>(
+			"set_state with telemetry sampled 1/64", pages, trace, checksum);
+		std::printf("overhead: full %.1f%%, sampled %.1f%%\n",
+			(full / base - 1.0) * 100.0,
+			(sampled / base - 1.0) * 100.0);
+	}
+
+	auto const matrix = full_telemetry::snapshot();
+	std::printf("recorded: %llu transitions, %llu sampled\n",
+		static_cast<unsigned long long>(matrix.total()),
+		static_cast<unsigned long long>(sampled_telemetry::snapshot().total()));
+}
@@ -0,0 +1,145 @@
+#include "bench_utils.hpp"
+#include "perf_counters.hpp"
+
+#include <putl/state_ptr.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+	/// \brief A list node carrying a mark bit in its link: 16 bytes.
+	struct alignas(8) TaggedListNode {
+		std::uint64_t                                          value;
+		putl::state_ptr<TaggedListNode, std::uintptr_t, 1> next;
+	};
+
+	/// \brief The equivalent list node with a separate mark field: 24 bytes.
+	struct UntaggedListNode {
+		std::uint64_t     value;
+		UntaggedListNode* next;
+		bool              marked;
+	};
+
+	/// \brief A binary search tree node carrying its color in the left link: 24 bytes.
+	struct alignas(8) TaggedTreeNode {
+		std::uint64_t                                          key;
+		putl::state_ptr<TaggedTreeNode, std::uintptr_t, 1> left;
+		putl::state_ptr<TaggedTreeNode, std::uintptr_t, 1> right;
+	};
+
+	/// \brief The equivalent tree node with a separate color field: 32 bytes.
+	struct UntaggedTreeNode {
+		std::uint64_t     key;
+		UntaggedTreeNode* left;
+		UntaggedTreeNode* right;
+		bool              red;
+	};
+
+	/// \brief Returns the order in which the list nodes are linked.
+	auto random_order(std::size_t count) -> std::vector<std::size_t> {
+		std::vector<std::size_t> order(count);
+		std::iota(order.begin(), order.end(), std::size_t{0});
+		std::shuffle(order.begin(), order.end(), std::mt19937_64{42});
+		return order;
+	}
+
+	void bench_lists(std::size_t count, bench::perf_counters& counters) {
+		auto const order = random_order(count);
+		std::vector<TaggedListNode>   tagged(count, TaggedListNode{0, {nullptr, 0}});
+		std::vector<UntaggedListNode> untagged(count, UntaggedListNode{0, nullptr, false});
+		for (std::size_t i = 0; i < count; ++i) {
+			auto const node = order[i];
+			auto const next = i + 1 < count ? order[i + 1] : count;
+			tagged[node].value     = node;
+			tagged[node].next      = {next < count ? &tagged[next] : nullptr, node % 3 == 0 ? 1u : 0u};
+			untagged[node].value   = node;
+			untagged[node].next    = next < count ? &untagged[next] : nullptr;
+			untagged[node].marked  = node % 3 == 0;
+		}
+
+		std::uint64_t sum = 0;
+		auto seconds = bench::time_it([&] {
+			for (auto node = &tagged[order[0]]; node != nullptr;) {
+				sum += node->next.get_state() != 0 ? node->value : 0;
+				node = node->next.get_ptr();
+			}
+		}, counters);
+		bench::report("list traversal tagged", count, seconds, counters);
+		seconds = bench::time_it([&] {
+			for (auto node = &untagged[order[0]]; node != nullptr; node = node->next) {
+				sum += node->marked ? node->value : 0;
+			}
+		}, counters);
+		bench::report("list traversal untagged", count, seconds, counters);
+		bench::do_not_optimize(sum);
+	}
+
+	void bench_trees(std::size_t count, bench::perf_counters& counters) {
+		std::mt19937_64 rng{42};
+		std::vector<TaggedTreeNode>   tagged(count, TaggedTreeNode{0, {nullptr, 0}, {nullptr, 0}});
+		std::vector<UntaggedTreeNode> untagged(count, UntaggedTreeNode{0, nullptr, nullptr, false});
+		std::vector<std::uint64_t>    keys(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			keys[i]            = rng();
+			auto const red     = keys[i] % 2 == 0;
+			tagged[i].key      = keys[i];
+			tagged[i].left     = {nullptr, red ? 1u : 0u};
+			untagged[i].key    = keys[i];
+			untagged[i].red    = red;
+			if (i == 0) {
+				continue;
+			}
+			for (auto parent = &tagged[0];;) {
+				auto& link = keys[i] < parent->key ? parent->left : parent->right;
+				if (link.get_ptr() == nullptr) {
+					link = {&tagged[i], link.get_state()};
+					break;
+				}
+				parent = link.get_ptr();
+			}
+			for (auto parent = &untagged[0];;) {
+				auto& link = keys[i] < parent->key ? parent->left : parent->right;
+				if (link == nullptr) {
+					link = &untagged[i];
+					break;
+				}
+				parent = link;
+			}
+		}
+		std::shuffle(keys.begin(), keys.end(), rng);
+
+		std::uint64_t reds = 0;
+		auto seconds = bench::time_it([&] {
+			for (auto const key : keys) {
+				for (auto node = &tagged[0]; node != nullptr && node->key != key;) {
+					reds += node->left.get_state();
+					node = key < node->key ? node->left.get_ptr() : node->right.get_ptr();
+				}
+			}
+		}, counters);
+		bench::report("tree lookup tagged", count, seconds, counters);
+		seconds = bench::time_it([&] {
+			for (auto const key : keys) {
+				for (auto node = &untagged[0]; node != nullptr && node->key != key;) {
+					reds += node->red ? 1u : 0u;
+					node = key < node->key ? node->left : node->right;
+				}
+			}
+		}, counters);
+		bench::report("tree lookup untagged", count, seconds, counters);
+		bench::do_not_optimize(reds);
+	}
+}
+
+int main(int argc, char** argv) {
+	auto const count = bench::size_arg(argc, argv, 10000000);
+	bench::perf_counters counters;
+	if (!counters.any_available()) {
+		std::printf("perf events are unavailable, reporting wall-clock times only\n");
+	}
+	bench_lists(count, counters);
+	bench_trees(count, counters);
+}
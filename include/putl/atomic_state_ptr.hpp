@@ -0,0 +1,192 @@
+#ifndef POINTER_UTILS_ATOMIC_STATE_PTR_HPP
+#define POINTER_UTILS_ATOMIC_STATE_PTR_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <atomic>
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	/// \brief An atomic cell holding a state_ptr.
+	///
+	/// Pointer and state share a single machine word, so every operation on
+	/// an atomic_state_ptr is one atomic operation on that word.
+	///
+	/// Besides the usual load, store, exchange and compare-exchange operations
+	/// this provides fetch_or_state and fetch_and_state that only touch the
+	/// state bits. These allow to set or clear flags (e.g. reference bits) with
+	/// a single read-modify-write instruction instead of a CAS loop.
+	template<typename T,
+	         typename S = std::uintptr_t,
+	         std::size_t req_state_bits = detail::default_state_bits<T, S>()>
+	class atomic_state_ptr {
+	public:
+		/// \brief The state_ptr type that is stored in this atomic cell.
+		using value_type = state_ptr<T, S, req_state_bits>;
+
+		/// \brief Type representing a pointer to an element type.
+		using pointer_type = typename value_type::pointer_type;
+
+		/// \brief The user defined type used to represent the state.
+		using state_type = typename value_type::state_type;
+
+		/// \brief The type used internally to store the pointer and the state.
+		using internal_type = typename value_type::internal_type;
+
+		/// \brief Creates an atomic_state_ptr initialized by a null-pointer and a zero state.
+		constexpr atomic_state_ptr() noexcept;
+
+		/// \brief Creates an atomic_state_ptr initialized by the given state_ptr.
+		constexpr atomic_state_ptr(value_type desired) noexcept;
+
+		atomic_state_ptr(atomic_state_ptr const&) = delete;
+		atomic_state_ptr& operator=(atomic_state_ptr const&) = delete;
+
+		/// \brief Returns `true` if the operations on this type are lock-free.
+		auto is_lock_free() const noexcept -> bool;
+
+		/// \brief Atomically loads the stored state_ptr.
+		auto load(std::memory_order order = std::memory_order_seq_cst) const noexcept -> value_type;
+
+		/// \brief Atomically replaces the stored state_ptr with the given one.
+		void store(value_type desired, std::memory_order order = std::memory_order_seq_cst) noexcept;
+
+		/// \brief Atomically replaces the stored state_ptr and returns the previous one.
+		auto exchange(value_type desired, std::memory_order order = std::memory_order_seq_cst) noexcept -> value_type;
+
+		/// \brief Atomically compares the stored state_ptr with `expected` and replaces it
+		///        with `desired` if both are equal. Otherwise loads the stored value into `expected`.
+		///
+		/// Note: Pointer and state are compared as a whole.
+		auto compare_exchange_weak(
+			value_type&       expected,
+			value_type        desired,
+			std::memory_order order = std::memory_order_seq_cst
+		) noexcept -> bool;
+
+		/// \brief Same as compare_exchange_weak but does not fail spuriously.
+		auto compare_exchange_strong(
+			value_type&       expected,
+			value_type        desired,
+			std::memory_order order = std::memory_order_seq_cst
+		) noexcept -> bool;
+
+		/// \brief Atomically loads the wrapped pointer.
+		auto get_ptr(std::memory_order order = std::memory_order_seq_cst) const noexcept -> pointer_type;
+
+		/// \brief Atomically loads the current state.
+		auto get_state(std::memory_order order = std::memory_order_seq_cst) const noexcept -> state_type;
+
+		/// \brief Atomically ORs the given bits into the state and returns the previous state.
+		///
+		/// The pointer bits are never modified by this operation.
+		auto fetch_or_state(state_type bits, std::memory_order order = std::memory_order_seq_cst) noexcept -> state_type;
+
+		/// \brief Atomically ANDs the given bits into the state and returns the previous state.
+		///
+		/// The pointer bits are never modified by this operation.
+		auto fetch_and_state(state_type bits, std::memory_order order = std::memory_order_seq_cst) noexcept -> state_type;
+
+	private:
+		/// \brief Converts the given internal representation into a state_ptr.
+		static auto from_bits(internal_type bits) noexcept -> value_type;
+
+		/// \brief Returns the internal representation of the given state_ptr.
+		static constexpr auto to_bits(value_type const& p) noexcept -> internal_type;
+
+	private:
+		std::atomic<internal_type> m_ptr_and_state;
+	};
+
+	/// =======================================================================
+	///  Implementation of constructors and member functions.
+	/// =======================================================================
+
+	template<typename T, typename S, std::size_t StateBits>
+	constexpr atomic_state_ptr<T, S, StateBits>::atomic_state_ptr() noexcept :
+		m_ptr_and_state{0}
+	{}
+
+	template<typename T, typename S, std::size_t StateBits>
+	constexpr atomic_state_ptr<T, S, StateBits>::atomic_state_ptr(value_type desired) noexcept :
+		m_ptr_and_state{to_bits(desired)}
+	{}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto atomic_state_ptr<T, S, StateBits>::from_bits(internal_type bits) noexcept -> value_type {
+		return value_type::from_raw(bits);
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	constexpr auto atomic_state_ptr<T, S, StateBits>::to_bits(value_type const& p) noexcept -> internal_type {
+		return p.raw();
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto atomic_state_ptr<T, S, StateBits>::is_lock_free() const noexcept -> bool {
+		return m_ptr_and_state.is_lock_free();
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto atomic_state_ptr<T, S, StateBits>::load(std::memory_order order) const noexcept -> value_type {
+		return from_bits(m_ptr_and_state.load(order));
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	void atomic_state_ptr<T, S, StateBits>::store(value_type desired, std::memory_order order) noexcept {
+		m_ptr_and_state.store(to_bits(desired), order);
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto atomic_state_ptr<T, S, StateBits>::exchange(value_type desired, std::memory_order order) noexcept -> value_type {
+		return from_bits(m_ptr_and_state.exchange(to_bits(desired), order));
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto atomic_state_ptr<T, S, StateBits>::compare_exchange_weak(
+		value_type&       expected,
+		value_type        desired,
+		std::memory_order order
+	) noexcept -> bool {
+		auto bits = to_bits(expected);
+		auto const success = m_ptr_and_state.compare_exchange_weak(bits, to_bits(desired), order);
+		expected = from_bits(bits);
+		return success;
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto atomic_state_ptr<T, S, StateBits>::compare_exchange_strong(
+		value_type&       expected,
+		value_type        desired,
+		std::memory_order order
+	) noexcept -> bool {
+		auto bits = to_bits(expected);
+		auto const success = m_ptr_and_state.compare_exchange_strong(bits, to_bits(desired), order);
+		expected = from_bits(bits);
+		return success;
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto atomic_state_ptr<T, S, StateBits>::get_ptr(std::memory_order order) const noexcept -> pointer_type {
+		return load(order).get_ptr();
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto atomic_state_ptr<T, S, StateBits>::get_state(std::memory_order order) const noexcept -> state_type {
+		return load(order).get_state();
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto atomic_state_ptr<T, S, StateBits>::fetch_or_state(state_type bits, std::memory_order order) noexcept -> state_type {
+		value_type::check(0, bits);
+		auto const prev = m_ptr_and_state.fetch_or(static_cast<internal_type>(bits) & value_type::state_mask, order);
+		return static_cast<state_type>(prev & value_type::state_mask);
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto atomic_state_ptr<T, S, StateBits>::fetch_and_state(state_type bits, std::memory_order order) noexcept -> state_type {
+		auto const prev = m_ptr_and_state.fetch_and(static_cast<internal_type>(bits) | value_type::ptr_mask, order);
+		return static_cast<state_type>(prev & value_type::state_mask);
+	}
+}
+
+#endif // POINTER_UTILS_ATOMIC_STATE_PTR_HPP
@@ -0,0 +1,149 @@
+#ifndef POINTER_UTILS_BATCH_LOOKUP_HPP
+#define POINTER_UTILS_BATCH_LOOKUP_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	/// \brief The outcome of a single hop of a lookup run by batch_lookup.
+	///
+	/// Either the lookup is done and `link` is its result, or the lookup
+	/// continues at `link`. Continuing at a null link finishes the lookup
+	/// with that null link as result, i.e. not found.
+	template<typename Link>
+	struct batch_step {
+		Link link;
+		bool done;
+
+		/// \brief Finishes the lookup with the given result.
+		static auto finish(Link result) -> batch_step;
+
+		/// \brief Continues the lookup at the given link.
+		static auto follow(Link next) -> batch_step;
+	};
+
+	/// \brief Runs one lookup per key in `[first, last)` with up to `Width`
+	///        lookups interleaved and writes their results to `results`.
+	///
+	/// This implements asynchronous memory access chaining (AMAC): instead of
+	/// waiting for the cache miss of every hop, each hop prefetches the next
+	/// node of its lookup and switches to the next in-flight lookup, so that
+	/// up to `Width` misses are outstanding at once. A finished lookup is
+	/// immediately replaced by the lookup of the next key.
+	///
+	/// - `start(key)` returns the first link of the lookup of `key`, e.g. the
+	///   hash bucket head or the tree root. A null link finishes the lookup.
+	/// - `step(key, link)` visits the non-null `link` and returns the
+	///   batch_step to take, e.g. `batch_step<L>::follow(link->next)`.
+	///
+	/// Links are state_ptr or anything else with a `prefetch(prefetch_locality)`
+	/// member and an explicit conversion to `bool`. The result of the `i`-th key
+	/// is written to `results[i]`; lookups finish out of order, so `results`
+	/// must be a random access iterator.
+	template<std::size_t Width, typename KeyIt, typename ResultIt, typename Start, typename Step>
+	void batch_lookup(KeyIt first, KeyIt last, ResultIt results, Start start, Step step);
+
+	/// =======================================================================
+	///  Implementation of batch_step.
+	/// =======================================================================
+
+	template<typename Link>
+	auto batch_step<Link>::finish(Link result) -> batch_step {
+		return batch_step{std::move(result), true};
+	}
+
+	template<typename Link>
+	auto batch_step<Link>::follow(Link next) -> batch_step {
+		return batch_step{std::move(next), false};
+	}
+
+	/// =======================================================================
+	///  Implementation of batch_lookup.
+	/// =======================================================================
+
+	namespace detail {
+		/// \brief An in-flight lookup of batch_lookup.
+		///
+		/// The link lives in a union since links such as state_ptr are not
+		/// default constructible; it is only alive while the slot is in use.
+		template<typename KeyIt, typename Link>
+		struct batch_slot {
+			static_assert(std::is_trivially_destructible<Link>::value, "batch_lookup requires trivially destructible links");
+
+			batch_slot() noexcept {}
+
+			KeyIt       key;
+			std::size_t index;
+			union {
+				Link current;
+			};
+		};
+	}
+
+	template<std::size_t Width, typename KeyIt, typename ResultIt, typename Start, typename Step>
+	void batch_lookup(KeyIt first, KeyIt last, ResultIt results, Start start, Step step) {
+		static_assert(Width > 0, "batch_lookup requires at least one lookup in flight");
+		using link = typename std::decay<decltype(start(*first))>::type;
+		using slot = detail::batch_slot<KeyIt, link>;
+		using difference_type = typename std::iterator_traits<ResultIt>::difference_type;
+
+		std::size_t next_index = 0;
+		// Starts the lookup of the next key in the given slot, finishing
+		// lookups without a first link right away. Returns false if there
+		// are no keys left.
+		auto const refill = [&](slot& s) -> bool {
+			for (; first != last; ++first, ++next_index) {
+				auto l = start(*first);
+				if (!static_cast<bool>(l)) {
+					results[static_cast<difference_type>(next_index)] = l;
+					continue;
+				}
+				l.prefetch();
+				s.key   = first;
+				s.index = next_index;
+				::new (static_cast<void*>(&s.current)) link(std::move(l));
+				++first;
+				++next_index;
+				return true;
+			}
+			return false;
+		};
+
+		slot slots[Width];
+		std::size_t active = 0;
+		while (active < Width && refill(slots[active])) {
+			++active;
+		}
+		while (active > 0) {
+			for (std::size_t i = 0; i < active;) {
+				auto& s = slots[i];
+				auto r = step(*s.key, s.current);
+				if (!r.done && static_cast<bool>(r.link)) {
+					s.current = std::move(r.link);
+					s.current.prefetch();
+					++i;
+					continue;
+				}
+				results[static_cast<difference_type>(s.index)] = std::move(r.link);
+				if (refill(s)) {
+					++i;
+					continue;
+				}
+				// No keys left, the last in-flight lookup takes this slot.
+				--active;
+				if (i != active) {
+					s.key   = slots[active].key;
+					s.index = slots[active].index;
+					s.current = slots[active].current;
+				}
+			}
+		}
+	}
+}
+
+#endif // POINTER_UTILS_BATCH_LOOKUP_HPP
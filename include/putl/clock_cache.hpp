@@ -0,0 +1,328 @@
+#ifndef POINTER_UTILS_CLOCK_CACHE_HPP
+#define POINTER_UTILS_CLOCK_CACHE_HPP
+
+#include <putl/atomic_state_ptr.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	/// \brief A fixed-capacity cache using the CLOCK (second-chance) replacement policy.
+	///
+	/// Every slot of the cache is an atomic_state_ptr to its entry whose state bit
+	/// holds the reference bit of the entry. A cache hit only sets this bit with a
+	/// single relaxed fetch_or and never moves any entry around, in contrast to LRU
+	/// lists that need to splice the hit entry to the front of the list.
+	///
+	/// When the cache is full the clock hand sweeps over the slots, clears the
+	/// reference bit of every referenced entry it passes and evicts the first
+	/// entry that has not been referenced since the last sweep.
+	///
+	/// Note: find may be called concurrently with other calls to find, insertion
+	///       and removal require exclusive access. See concurrent_clock_cache
+	///       for a thread-safe variant.
+	template<typename K,
+	         typename V,
+	         typename Hash     = std::hash<K>,
+	         typename KeyEqual = std::equal_to<K>>
+	class clock_cache {
+	public:
+		/// \brief The type of the keys.
+		using key_type = K;
+
+		/// \brief The type of the cached values.
+		using mapped_type = V;
+
+		/// \brief Creates an empty clock_cache that is able to hold `capacity` entries.
+		///
+		/// Throws std::invalid_argument if `capacity` is zero.
+		explicit clock_cache(std::size_t capacity);
+
+		clock_cache(clock_cache const&) = delete;
+		clock_cache& operator=(clock_cache const&) = delete;
+
+		/// \brief Destroys all cached entries.
+		~clock_cache();
+
+		/// \brief Returns a pointer to the cached value associated to the given key
+		///        and marks it as referenced, or returns nullptr if there is none.
+		auto find(key_type const& key) const -> mapped_type*;
+
+		/// \brief Associates the given value to the given key and marks it as referenced.
+		///
+		/// Replaces the value if the key is already cached. Evicts an entry
+		/// that has not been referenced recently if the cache is full.
+		/// Returns a reference to the cached value.
+		auto insert(key_type key, mapped_type value) -> mapped_type&;
+
+		/// \brief Removes the entry associated to the given key.
+		///
+		/// Returns `true` if an entry was removed.
+		auto erase(key_type const& key) -> bool;
+
+		/// \brief Returns the number of cached entries.
+		auto size() const noexcept -> std::size_t;
+
+		/// \brief Returns the maximum number of cached entries.
+		auto capacity() const noexcept -> std::size_t;
+
+	private:
+		/// \brief The state bits of a slot.
+		enum slot_state : std::uintptr_t {
+			unreferenced = 0,
+			referenced   = 1
+		};
+
+		/// \brief A cached entry as it is pointed to by its slot.
+		struct alignas(2) alignas(K) alignas(V) entry {
+			key_type    key;
+			mapped_type value;
+		};
+
+		using slot_type = atomic_state_ptr<entry, std::uintptr_t, 1>;
+		using slot_ptr  = typename slot_type::value_type;
+
+		/// \brief Advances the clock hand until it points to a free or unreferenced slot
+		///        and returns the index of that slot. Evicts the entry of the found slot.
+		auto evict() -> std::size_t;
+
+	private:
+		std::unique_ptr<slot_type[]>                                m_slots;
+		std::unordered_map<key_type, std::size_t, Hash, KeyEqual>  m_index;
+		std::size_t                                                 m_capacity;
+		std::size_t                                                 m_hand;
+	};
+
+	/// \brief A thread-safe clock_cache that is split into independently locked shards.
+	///
+	/// Lookups only acquire their shard's lock in shared mode and mark the entry
+	/// referenced via an atomic fetch_or so that concurrent hits never serialize.
+	/// Insertions and removals acquire their shard's lock exclusively.
+	///
+	/// Since entries may be evicted as soon as the lock is released, lookups
+	/// return copies of the cached values.
+	template<typename K,
+	         typename V,
+	         typename Hash     = std::hash<K>,
+	         typename KeyEqual = std::equal_to<K>>
+	class concurrent_clock_cache {
+	public:
+		/// \brief The type of the keys.
+		using key_type = K;
+
+		/// \brief The type of the cached values.
+		using mapped_type = V;
+
+		/// \brief Creates an empty concurrent_clock_cache with the given total capacity
+		///        that is distributed evenly among `shards` shards.
+		///
+		/// Throws std::invalid_argument unless every shard gets a non-zero capacity.
+		concurrent_clock_cache(std::size_t capacity, std::size_t shards);
+
+		/// \brief Copies the cached value associated to the given key into `out`
+		///        and marks it as referenced.
+		///
+		/// Returns `false` and leaves `out` untouched if there is no such value.
+		auto find(key_type const& key, mapped_type& out) const -> bool;
+
+		/// \brief Associates the given value to the given key.
+		auto insert(key_type key, mapped_type value) -> void;
+
+		/// \brief Removes the entry associated to the given key.
+		///
+		/// Returns `true` if an entry was removed.
+		auto erase(key_type const& key) -> bool;
+
+		/// \brief Returns the number of cached entries.
+		///
+		/// Note: The result may be outdated if there are concurrent modifications.
+		auto size() const -> std::size_t;
+
+	private:
+		/// \brief A single independently locked clock_cache.
+		///
+		/// Shards are allocated separately and padded to avoid false sharing of
+		/// the locks of neighbouring shards. (Over-aligned new requires C++17.)
+		struct shard {
+			explicit shard(std::size_t capacity) : cache{capacity} {}
+
+			mutable std::shared_timed_mutex      mutex;
+			clock_cache<K, V, Hash, KeyEqual>    cache;
+			char                                 padding[64];
+		};
+
+		/// \brief Returns the shard responsible for the given key.
+		auto shard_for(key_type const& key) const -> shard&;
+
+	private:
+		std::vector<std::unique_ptr<shard>> m_shards;
+		Hash                                m_hash;
+	};
+
+	/// =======================================================================
+	///  Implementation of clock_cache.
+	/// =======================================================================
+
+	template<typename K, typename V, typename H, typename E>
+	clock_cache<K, V, H, E>::clock_cache(std::size_t capacity) :
+		m_slots{new slot_type[capacity]},
+		m_index{},
+		m_capacity{capacity},
+		m_hand{0}
+	{
+		if (capacity == 0) {
+			throw std::invalid_argument{"a clock_cache requires a non-zero capacity"};
+		}
+		m_index.reserve(capacity);
+	}
+
+	template<typename K, typename V, typename H, typename E>
+	clock_cache<K, V, H, E>::~clock_cache() {
+		for (std::size_t i = 0; i < m_capacity; ++i) {
+			delete m_slots[i].get_ptr(std::memory_order_relaxed);
+		}
+	}
+
+	template<typename K, typename V, typename H, typename E>
+	auto clock_cache<K, V, H, E>::find(key_type const& key) const -> mapped_type* {
+		auto const it = m_index.find(key);
+		if (it == m_index.end()) {
+			return nullptr;
+		}
+		auto& slot = m_slots[it->second];
+		slot.fetch_or_state(referenced, std::memory_order_relaxed);
+		return &slot.get_ptr(std::memory_order_relaxed)->value;
+	}
+
+	template<typename K, typename V, typename H, typename E>
+	auto clock_cache<K, V, H, E>::evict() -> std::size_t {
+		for (;;) {
+			auto const index = m_hand;
+			m_hand = (m_hand + 1) % m_capacity;
+			auto& slot = m_slots[index];
+			auto  curr = slot.load(std::memory_order_relaxed);
+			if (curr.get_ptr() == nullptr) {
+				return index;
+			}
+			if (slot.fetch_and_state(unreferenced, std::memory_order_relaxed) == referenced) {
+				continue; // second chance
+			}
+			m_index.erase(curr->key);
+			delete curr.get_ptr();
+			slot.store(slot_ptr{nullptr, unreferenced}, std::memory_order_relaxed);
+			return index;
+		}
+	}
+
+	template<typename K, typename V, typename H, typename E>
+	auto clock_cache<K, V, H, E>::insert(key_type key, mapped_type value) -> mapped_type& {
+		auto const it = m_index.find(key);
+		if (it != m_index.end()) {
+			auto& slot = m_slots[it->second];
+			auto  e    = slot.get_ptr(std::memory_order_relaxed);
+			e->value = std::move(value);
+			slot.fetch_or_state(referenced, std::memory_order_relaxed);
+			return e->value;
+		}
+		auto const index = evict();
+		// The entry is owned by the unique_ptr until it is stored in its slot
+		// so that it does not leak if inserting into the index throws.
+		std::unique_ptr<entry> e{new entry{std::move(key), std::move(value)}};
+		m_index.emplace(e->key, index);
+		// New entries start unreferenced so that entries that are never hit
+		// again are evicted on the next sweep.
+		m_slots[index].store(slot_ptr{e.get(), unreferenced}, std::memory_order_relaxed);
+		return e.release()->value;
+	}
+
+	template<typename K, typename V, typename H, typename E>
+	auto clock_cache<K, V, H, E>::erase(key_type const& key) -> bool {
+		auto const it = m_index.find(key);
+		if (it == m_index.end()) {
+			return false;
+		}
+		auto& slot = m_slots[it->second];
+		m_index.erase(it);
+		delete slot.exchange(slot_ptr{nullptr, unreferenced}, std::memory_order_relaxed).get_ptr();
+		return true;
+	}
+
+	template<typename K, typename V, typename H, typename E>
+	auto clock_cache<K, V, H, E>::size() const noexcept -> std::size_t {
+		return m_index.size();
+	}
+
+	template<typename K, typename V, typename H, typename E>
+	auto clock_cache<K, V, H, E>::capacity() const noexcept -> std::size_t {
+		return m_capacity;
+	}
+
+	/// =======================================================================
+	///  Implementation of concurrent_clock_cache.
+	/// =======================================================================
+
+	template<typename K, typename V, typename H, typename E>
+	concurrent_clock_cache<K, V, H, E>::concurrent_clock_cache(std::size_t capacity, std::size_t shards) :
+		m_shards{},
+		m_hash{}
+	{
+		if (shards == 0 || capacity < shards) {
+			throw std::invalid_argument{"every shard requires a non-zero capacity"};
+		}
+		m_shards.reserve(shards);
+		for (std::size_t i = 0; i < shards; ++i) {
+			auto const per_shard = capacity / shards + (i < capacity % shards ? 1 : 0);
+			m_shards.emplace_back(new shard{per_shard});
+		}
+	}
+
+	template<typename K, typename V, typename H, typename E>
+	auto concurrent_clock_cache<K, V, H, E>::shard_for(key_type const& key) const -> shard& {
+		return *m_shards[m_hash(key) % m_shards.size()];
+	}
+
+	template<typename K, typename V, typename H, typename E>
+	auto concurrent_clock_cache<K, V, H, E>::find(key_type const& key, mapped_type& out) const -> bool {
+		auto& s = shard_for(key);
+		std::shared_lock<std::shared_timed_mutex> lock{s.mutex};
+		auto const value = s.cache.find(key);
+		if (value == nullptr) {
+			return false;
+		}
+		out = *value;
+		return true;
+	}
+
+	template<typename K, typename V, typename H, typename E>
+	auto concurrent_clock_cache<K, V, H, E>::insert(key_type key, mapped_type value) -> void {
+		auto& s = shard_for(key);
+		std::lock_guard<std::shared_timed_mutex> lock{s.mutex};
+		s.cache.insert(std::move(key), std::move(value));
+	}
+
+	template<typename K, typename V, typename H, typename E>
+	auto concurrent_clock_cache<K, V, H, E>::erase(key_type const& key) -> bool {
+		auto& s = shard_for(key);
+		std::lock_guard<std::shared_timed_mutex> lock{s.mutex};
+		return s.cache.erase(key);
+	}
+
+	template<typename K, typename V, typename H, typename E>
+	auto concurrent_clock_cache<K, V, H, E>::size() const -> std::size_t {
+		std::size_t result = 0;
+		for (auto const& s : m_shards) {
+			std::shared_lock<std::shared_timed_mutex> lock{s->mutex};
+			result += s->cache.size();
+		}
+		return result;
+	}
+}
+
+#endif // POINTER_UTILS_CLOCK_CACHE_HPP
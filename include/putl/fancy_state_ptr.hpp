@@ -0,0 +1,489 @@
+#ifndef POINTER_UTILS_FANCY_STATE_PTR_HPP
+#define POINTER_UTILS_FANCY_STATE_PTR_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	namespace detail {
+		/// \brief Placeholder type that can never be referenced by users.
+		struct not_a_type {};
+
+		/// \brief Returns a reference to T or a reference to not_a_type if T is void.
+		///
+		/// This allows to declare pointer_to for fancy pointers to void.
+		template<typename T>
+		using pointee_reference_t = typename std::conditional<
+			std::is_void<T>::value, not_a_type, T>::type&;
+	}
+
+	/// \brief A state_ptr-like fancy pointer that can be used as `allocator_traits::pointer`
+	///        for allocator-aware standard containers.
+	///
+	/// In contrast to state_ptr the number of state bits is given explicitly,
+	/// so that the state survives rebinding and conversions to and from
+	/// `fancy_state_ptr<void>` which containers perform internally. Since
+	/// pointer arithmetic steps over whole elements, the alignment of every
+	/// non-void T must still provide the state bits; this is checked at
+	/// compile-time whenever a pointer to T is wrapped or advanced.
+	///
+	/// fancy_state_ptr satisfies the NullablePointer and random access iterator
+	/// requirements. Equality and ordering only consider the pointer value so that
+	/// containers comparing their node links are not confused by attached states.
+	/// Pointer arithmetic preserves the state.
+	template<typename T, std::size_t state_bits = 1>
+	class fancy_state_ptr {
+	public:
+		/// \brief The element type.
+		using element_type = T;
+
+		/// \brief Type representing a pointer to an element type.
+		using pointer_type = typename std::add_pointer<T>::type;
+
+		/// \brief Type representing a reference to the element type.
+		using reference_type = typename std::add_lvalue_reference<T>::type;
+
+		/// \brief The type used to represent the state.
+		using state_type = std::uintptr_t;
+
+		/// \brief The type used internally to store the pointer and the state.
+		using internal_type = std::uintptr_t;
+
+		/// \brief Iterator traits required for random access.
+		using value_type        = typename std::remove_cv<T>::type;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = fancy_state_ptr;
+		using reference         = reference_type;
+		using iterator_category = std::random_access_iterator_tag;
+
+		/// \brief Rebinds this fancy pointer to another element type keeping the state bits.
+		template<typename U>
+		using rebind = fancy_state_ptr<U, state_bits>;
+
+		/// \brief The maximum value that is possible to be stored as state.
+		constexpr static internal_type state_max = (internal_type{1} << state_bits) - 1u;
+
+		/// \brief The bit-mask to extract the state value out of the shared memory.
+		constexpr static internal_type state_mask = state_max;
+
+		/// \brief The bit-mask to extract the pointer value out of the shared memory.
+		constexpr static internal_type ptr_mask = ~state_mask;
+
+		static_assert(state_bits < 8 * sizeof(internal_type), "Too many state bits requested.");
+
+	public:
+		/// \brief Creates a fancy_state_ptr initialized by a null-pointer and a zero state.
+		constexpr fancy_state_ptr() noexcept;
+
+		/// \brief Creates a fancy_state_ptr initialized by a null-pointer and a zero state.
+		constexpr fancy_state_ptr(std::nullptr_t) noexcept;
+
+		/// \brief Creates a fancy_state_ptr pointing to the given pointee with the given state.
+		///
+		/// Panics if the pointer is insufficiently aligned or the state is out of bounds.
+		explicit fancy_state_ptr(pointer_type ptr, state_type state = 0) noexcept;
+
+		/// \brief Implicitly converts from fancy pointers to types whose pointers
+		///        implicitly convert to pointers of the element type, e.g. T to const T or T to void.
+		template<typename U,
+		         typename std::enable_if<std::is_convertible<U*, T*>::value, int>::type = 0>
+		fancy_state_ptr(fancy_state_ptr<U, state_bits> const& other) noexcept;
+
+		/// \brief Explicitly converts from fancy pointers whose pointers only convert
+		///        via static_cast to pointers of the element type, e.g. void to T.
+		template<typename U,
+		         typename std::enable_if<!std::is_convertible<U*, T*>::value, int>::type = 0,
+		         typename = decltype(static_cast<T*>(std::declval<U*>()))>
+		explicit fancy_state_ptr(fancy_state_ptr<U, state_bits> const& other) noexcept;
+
+		/// \brief Returns a fancy pointer to the given reference with a zero state.
+		///
+		/// Required by std::pointer_traits.
+		static auto pointer_to(detail::pointee_reference_t<T> r) noexcept -> fancy_state_ptr;
+
+		/// \brief Sets the state value of this fancy_state_ptr to the given value.
+		///
+		/// Panics if the given state is out of bounds.
+		void set_state(state_type new_state) noexcept;
+
+		/// \brief Returns the current state of this fancy_state_ptr.
+		auto get_state() const noexcept -> state_type;
+
+		/// \brief Returns the wrapped pointer of this fancy_state_ptr.
+		auto get_ptr() const noexcept -> pointer_type;
+
+		/// \brief Forwards to the wrapped pointer as reference.
+		auto operator*() const noexcept -> reference_type;
+
+		/// \brief Forwards to the wrapped pointer.
+		auto operator->() const noexcept -> pointer_type;
+
+		/// \brief Forwards to the element at the given offset.
+		auto operator[](difference_type n) const noexcept -> reference_type;
+
+		/// \brief Returns false if this fancy_state_ptr wraps nullptr, and returns true otherwise.
+		explicit operator bool() const noexcept;
+
+		auto operator++() noexcept -> fancy_state_ptr&;
+		auto operator--() noexcept -> fancy_state_ptr&;
+		auto operator++(int) noexcept -> fancy_state_ptr;
+		auto operator--(int) noexcept -> fancy_state_ptr;
+		auto operator+=(difference_type n) noexcept -> fancy_state_ptr&;
+		auto operator-=(difference_type n) noexcept -> fancy_state_ptr&;
+
+		template<typename U, std::size_t B>
+		friend class fancy_state_ptr;
+
+	private:
+		/// \brief Returns the bits representing the pointer value as internal type.
+		constexpr auto get_ptr_bits() const noexcept -> internal_type;
+
+		/// \brief Returns the size of an element in bytes for pointer arithmetic.
+		constexpr static auto element_size() noexcept -> difference_type;
+
+		/// \brief The maximum number of state bits that pointers to T can carry.
+		///
+		/// Note: This is a function instead of a constant so that T is only required
+		///       to be complete when wrapping or advancing a pointer. This allows
+		///       for self-referential types, e.g. container nodes.
+		constexpr static auto state_bits_max() noexcept -> std::size_t;
+
+	private:
+		internal_type m_ptr_and_state;
+	};
+
+	/// \brief An allocator that hands out fancy_state_ptr instead of raw pointers.
+	///
+	/// Allocator-aware standard containers store their internal links as
+	/// `allocator_traits::pointer`, so these links are able to carry states
+	/// such as GC marks or NUMA node ids.
+	///
+	/// All allocations are aligned to `alignof(T)` which provides the state bits.
+	/// Over-aligned types require C++17 aligned allocation.
+	template<typename T, std::size_t state_bits = 1>
+	class state_allocator {
+	public:
+		using value_type         = T;
+		using pointer            = fancy_state_ptr<T, state_bits>;
+		using const_pointer      = fancy_state_ptr<T const, state_bits>;
+		using void_pointer       = fancy_state_ptr<void, state_bits>;
+		using const_void_pointer = fancy_state_ptr<void const, state_bits>;
+		using size_type          = std::size_t;
+		using difference_type    = std::ptrdiff_t;
+
+		template<typename U>
+		struct rebind {
+			using other = state_allocator<U, state_bits>;
+		};
+
+		state_allocator() noexcept = default;
+
+		template<typename U>
+		state_allocator(state_allocator<U, state_bits> const&) noexcept {}
+
+		/// \brief Returns the greatest number of elements that may be allocated at once.
+		constexpr auto max_size() const noexcept -> size_type;
+
+		/// \brief Allocates uninitialized storage for `n` elements.
+		///
+		/// Throws std::bad_array_new_length if `n` exceeds max_size.
+		auto allocate(size_type n) -> pointer;
+
+		/// \brief Deallocates the storage pointed to by `p`. The state of `p` is ignored.
+		void deallocate(pointer p, size_type n) noexcept;
+	};
+
+	/// =======================================================================
+	///  Implementation of fancy_state_ptr.
+	/// =======================================================================
+
+	template<typename T, std::size_t B>
+	constexpr fancy_state_ptr<T, B>::fancy_state_ptr() noexcept :
+		m_ptr_and_state{0}
+	{}
+
+	template<typename T, std::size_t B>
+	constexpr fancy_state_ptr<T, B>::fancy_state_ptr(std::nullptr_t) noexcept :
+		m_ptr_and_state{0}
+	{}
+
+	template<typename T, std::size_t B>
+	fancy_state_ptr<T, B>::fancy_state_ptr(pointer_type ptr, state_type state) noexcept :
+		m_ptr_and_state{reinterpret_cast<internal_type>(ptr)}
+	{
+		static_assert(B <= state_bits_max(), "The alignment of T is not sufficient to store the requested amount of state bits.");
+		assert((m_ptr_and_state & state_mask) == 0 && "pointer is insufficiently aligned for this fancy_state_ptr");
+		set_state(state);
+	}
+
+	template<typename T, std::size_t B>
+	template<typename U, typename std::enable_if<std::is_convertible<U*, T*>::value, int>::type>
+	fancy_state_ptr<T, B>::fancy_state_ptr(fancy_state_ptr<U, B> const& other) noexcept :
+		m_ptr_and_state{reinterpret_cast<internal_type>(static_cast<T*>(other.get_ptr())) | other.get_state()}
+	{
+		static_assert(B <= state_bits_max(), "The alignment of T is not sufficient to store the requested amount of state bits.");
+	}
+
+	template<typename T, std::size_t B>
+	template<typename U, typename std::enable_if<!std::is_convertible<U*, T*>::value, int>::type, typename>
+	fancy_state_ptr<T, B>::fancy_state_ptr(fancy_state_ptr<U, B> const& other) noexcept :
+		m_ptr_and_state{reinterpret_cast<internal_type>(static_cast<T*>(other.get_ptr())) | other.get_state()}
+	{
+		static_assert(B <= state_bits_max(), "The alignment of T is not sufficient to store the requested amount of state bits.");
+	}
+
+	template<typename T, std::size_t B>
+	auto fancy_state_ptr<T, B>::pointer_to(detail::pointee_reference_t<T> r) noexcept -> fancy_state_ptr {
+		return fancy_state_ptr{std::addressof(r)};
+	}
+
+	template<typename T, std::size_t B>
+	constexpr auto fancy_state_ptr<T, B>::get_ptr_bits() const noexcept -> internal_type {
+		return m_ptr_and_state & ptr_mask;
+	}
+
+	template<typename T, std::size_t B>
+	constexpr auto fancy_state_ptr<T, B>::element_size() noexcept -> difference_type {
+		return static_cast<difference_type>(sizeof(typename std::conditional<std::is_void<T>::value, char, T>::type));
+	}
+
+	template<typename T, std::size_t B>
+	constexpr auto fancy_state_ptr<T, B>::state_bits_max() noexcept -> std::size_t {
+		return std::is_void<T>::value
+			? 8 * sizeof(internal_type) - 1
+			: detail::log2(alignof(typename std::conditional<std::is_void<T>::value, char, T>::type));
+	}
+
+	template<typename T, std::size_t B>
+	void fancy_state_ptr<T, B>::set_state(state_type new_state) noexcept {
+		assert(new_state <= state_max && "state value is out of bounds for this fancy_state_ptr");
+		m_ptr_and_state = get_ptr_bits() | new_state;
+	}
+
+	template<typename T, std::size_t B>
+	auto fancy_state_ptr<T, B>::get_state() const noexcept -> state_type {
+		return m_ptr_and_state & state_mask;
+	}
+
+	template<typename T, std::size_t B>
+	auto fancy_state_ptr<T, B>::get_ptr() const noexcept -> pointer_type {
+		return reinterpret_cast<pointer_type>(get_ptr_bits());
+	}
+
+	template<typename T, std::size_t B>
+	auto fancy_state_ptr<T, B>::operator*() const noexcept -> reference_type {
+		return *get_ptr();
+	}
+
+	template<typename T, std::size_t B>
+	auto fancy_state_ptr<T, B>::operator->() const noexcept -> pointer_type {
+		return get_ptr();
+	}
+
+	template<typename T, std::size_t B>
+	auto fancy_state_ptr<T, B>::operator[](difference_type n) const noexcept -> reference_type {
+		return get_ptr()[n];
+	}
+
+	template<typename T, std::size_t B>
+	fancy_state_ptr<T, B>::operator bool() const noexcept {
+		return get_ptr_bits() != 0;
+	}
+
+	template<typename T, std::size_t B>
+	auto fancy_state_ptr<T, B>::operator+=(difference_type n) noexcept -> fancy_state_ptr& {
+		// Steps of whole elements keep the state bits intact since the alignment
+		// of T provides them.
+		static_assert(B <= state_bits_max(), "The alignment of T is not sufficient to store the requested amount of state bits.");
+		m_ptr_and_state += static_cast<internal_type>(n * element_size());
+		return *this;
+	}
+
+	template<typename T, std::size_t B>
+	auto fancy_state_ptr<T, B>::operator-=(difference_type n) noexcept -> fancy_state_ptr& {
+		static_assert(B <= state_bits_max(), "The alignment of T is not sufficient to store the requested amount of state bits.");
+		m_ptr_and_state -= static_cast<internal_type>(n * element_size());
+		return *this;
+	}
+
+	template<typename T, std::size_t B>
+	auto fancy_state_ptr<T, B>::operator++() noexcept -> fancy_state_ptr& {
+		return *this += 1;
+	}
+
+	template<typename T, std::size_t B>
+	auto fancy_state_ptr<T, B>::operator--() noexcept -> fancy_state_ptr& {
+		return *this -= 1;
+	}
+
+	template<typename T, std::size_t B>
+	auto fancy_state_ptr<T, B>::operator++(int) noexcept -> fancy_state_ptr {
+		auto copy = *this;
+		++*this;
+		return copy;
+	}
+
+	template<typename T, std::size_t B>
+	auto fancy_state_ptr<T, B>::operator--(int) noexcept -> fancy_state_ptr {
+		auto copy = *this;
+		--*this;
+		return copy;
+	}
+
+	/// =======================================================================
+	///  Implementation of fancy_state_ptr arithmetic and comparison operators.
+	/// =======================================================================
+
+	template<typename T, std::size_t B>
+	auto operator+(fancy_state_ptr<T, B> p, std::ptrdiff_t n) noexcept -> fancy_state_ptr<T, B> {
+		return p += n;
+	}
+
+	template<typename T, std::size_t B>
+	auto operator+(std::ptrdiff_t n, fancy_state_ptr<T, B> p) noexcept -> fancy_state_ptr<T, B> {
+		return p += n;
+	}
+
+	template<typename T, std::size_t B>
+	auto operator-(fancy_state_ptr<T, B> p, std::ptrdiff_t n) noexcept -> fancy_state_ptr<T, B> {
+		return p -= n;
+	}
+
+	template<typename T, std::size_t B>
+	auto operator-(fancy_state_ptr<T, B> const& lhs, fancy_state_ptr<T, B> const& rhs) noexcept -> std::ptrdiff_t {
+		return lhs.get_ptr() - rhs.get_ptr();
+	}
+
+	template<typename T, typename U, std::size_t B>
+	auto operator==(fancy_state_ptr<T, B> const& lhs, fancy_state_ptr<U, B> const& rhs) noexcept -> bool {
+		return lhs.get_ptr() == rhs.get_ptr();
+	}
+
+	template<typename T, typename U, std::size_t B>
+	auto operator!=(fancy_state_ptr<T, B> const& lhs, fancy_state_ptr<U, B> const& rhs) noexcept -> bool {
+		return !(lhs == rhs);
+	}
+
+	template<typename T, std::size_t B>
+	auto operator==(fancy_state_ptr<T, B> const& lhs, std::nullptr_t) noexcept -> bool {
+		return !lhs;
+	}
+
+	template<typename T, std::size_t B>
+	auto operator!=(fancy_state_ptr<T, B> const& lhs, std::nullptr_t) noexcept -> bool {
+		return static_cast<bool>(lhs);
+	}
+
+	template<typename T, std::size_t B>
+	auto operator==(std::nullptr_t, fancy_state_ptr<T, B> const& rhs) noexcept -> bool {
+		return !rhs;
+	}
+
+	template<typename T, std::size_t B>
+	auto operator!=(std::nullptr_t, fancy_state_ptr<T, B> const& rhs) noexcept -> bool {
+		return static_cast<bool>(rhs);
+	}
+
+	template<typename T, std::size_t B>
+	auto operator<(fancy_state_ptr<T, B> const& lhs, fancy_state_ptr<T, B> const& rhs) noexcept -> bool {
+		return std::less<T const*>{}(lhs.get_ptr(), rhs.get_ptr());
+	}
+
+	template<typename T, std::size_t B>
+	auto operator>(fancy_state_ptr<T, B> const& lhs, fancy_state_ptr<T, B> const& rhs) noexcept -> bool {
+		return rhs < lhs;
+	}
+
+	template<typename T, std::size_t B>
+	auto operator<=(fancy_state_ptr<T, B> const& lhs, fancy_state_ptr<T, B> const& rhs) noexcept -> bool {
+		return !(rhs < lhs);
+	}
+
+	template<typename T, std::size_t B>
+	auto operator>=(fancy_state_ptr<T, B> const& lhs, fancy_state_ptr<T, B> const& rhs) noexcept -> bool {
+		return !(lhs < rhs);
+	}
+
+	/// \brief Returns the raw pointer that is wrapped by the given fancy_state_ptr.
+	template<typename T, std::size_t B>
+	auto to_address(fancy_state_ptr<T, B> const& p) noexcept -> T* {
+		return p.get_ptr();
+	}
+
+	/// =======================================================================
+	///  Implementation of state_allocator.
+	/// =======================================================================
+
+	template<typename T, std::size_t B>
+	constexpr auto state_allocator<T, B>::max_size() const noexcept -> size_type {
+		return std::numeric_limits<size_type>::max() / sizeof(T);
+	}
+
+	template<typename T, std::size_t B>
+	auto state_allocator<T, B>::allocate(size_type n) -> pointer {
+		if (n > max_size()) {
+			throw std::bad_array_new_length{};
+		}
+#if defined(__cpp_aligned_new)
+		if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+			return pointer{static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}))};
+		}
+#else
+		static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned types require C++17 aligned allocation.");
+#endif
+		return pointer{static_cast<T*>(::operator new(n * sizeof(T)))};
+	}
+
+	template<typename T, std::size_t B>
+	void state_allocator<T, B>::deallocate(pointer p, size_type) noexcept {
+#if defined(__cpp_aligned_new)
+		if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+			::operator delete(static_cast<void*>(p.get_ptr()), std::align_val_t{alignof(T)});
+			return;
+		}
+#endif
+		::operator delete(static_cast<void*>(p.get_ptr()));
+	}
+
+	template<typename T, typename U, std::size_t B>
+	auto operator==(state_allocator<T, B> const&, state_allocator<U, B> const&) noexcept -> bool {
+		return true;
+	}
+
+	template<typename T, typename U, std::size_t B>
+	auto operator!=(state_allocator<T, B> const&, state_allocator<U, B> const&) noexcept -> bool {
+		return false;
+	}
+}
+
+/// ===========================================================================
+///  Implementation of std::pointer_traits::to_address support.
+/// ===========================================================================
+
+namespace std {
+	template<typename T, size_t StateBits>
+	struct pointer_traits<UTILS_STATE_PTR_HPP_NAMESPACE::fancy_state_ptr<T, StateBits>> {
+		using pointer         = UTILS_STATE_PTR_HPP_NAMESPACE::fancy_state_ptr<T, StateBits>;
+		using element_type    = T;
+		using difference_type = ptrdiff_t;
+
+		template<typename U>
+		using rebind = UTILS_STATE_PTR_HPP_NAMESPACE::fancy_state_ptr<U, StateBits>;
+
+		static auto pointer_to(UTILS_STATE_PTR_HPP_NAMESPACE::detail::pointee_reference_t<T> r) noexcept -> pointer {
+			return pointer::pointer_to(r);
+		}
+
+		static auto to_address(pointer const& p) noexcept -> T* {
+			return p.get_ptr();
+		}
+	};
+}
+
+#endif // POINTER_UTILS_FANCY_STATE_PTR_HPP
@@ -0,0 +1,566 @@
+#ifndef POINTER_UTILS_GRAPH_IO_HPP
+#define POINTER_UTILS_GRAPH_IO_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	namespace detail {
+		/// \brief The header at the start of every graph image.
+		struct graph_image_header {
+			std::uint64_t magic;
+			std::uint32_t version;
+			std::uint32_t root_count;
+			std::uint64_t size;
+		};
+
+		/// \brief The header directly preceding every object within a graph image.
+		struct graph_object_header {
+			std::uint32_t type;
+			std::uint32_t swizzled;
+		};
+
+		constexpr std::uint64_t graph_image_magic   = 0x48505247'4C545550ull; // "PUTLGRPH"
+		constexpr std::uint32_t graph_image_version = 1;
+
+		/// \brief Rounds `value` up to the next multiple of `align` which must be a power of two.
+		constexpr auto align_up(std::size_t value, std::size_t align) noexcept -> std::size_t {
+			return (value + align - 1) & ~(align - 1);
+		}
+	}
+
+	/// \brief Describes the object types of a graph and their state_ptr link fields.
+	///
+	/// Writer and reader of an image must use schemas with the same types
+	/// registered in the same order, since types are identified by their
+	/// registration index within images.
+	///
+	/// Registered types must be trivially copyable since they are copied
+	/// byte-wise into images.
+	class graph_schema {
+	public:
+		/// \brief Registers type T with the given state_ptr link fields.
+		///
+		/// The pointee types of all links must be registered before writing or reading.
+		template<typename T, typename... Links>
+		auto add(Links T::*... links) -> graph_schema&;
+
+	private:
+		friend class graph_writer;
+		friend class graph_reader;
+
+		/// \brief Type-erased operations on a single link field.
+		struct link_info {
+			/// \brief The type of the pointee.
+			std::type_index target;
+
+			/// \brief Returns the pointee of the link within the given object.
+			std::function<void const*(void const* obj)> pointee;
+
+			/// \brief Replaces the link within the given object copy by `offset | state`.
+			std::function<void(void* obj, std::uint64_t offset)> encode;
+
+			/// \brief Returns the offset encoded in the link within the given object.
+			std::function<std::uint64_t(void const* obj)> offset;
+
+			/// \brief Replaces the encoded link within the given object by a pointer
+			///        into the image starting at `base`, keeping the state.
+			std::function<void(void* obj, char* base)> swizzle;
+		};
+
+		/// \brief Description of a registered type.
+		struct type_info {
+			std::type_index        type;
+			std::size_t            size;
+			std::size_t            align;
+			std::vector<link_info> links;
+		};
+
+		template<typename T, typename U, typename S, std::size_t B, typename P>
+		static auto make_link(state_ptr<U, S, B, P> T::* link) -> link_info;
+
+		/// \brief Returns the registration index of the given type.
+		auto index_of(std::type_index type) const -> std::uint32_t;
+
+	private:
+		std::vector<type_info> m_types;
+	};
+
+	/// \brief Serializes graphs of objects linked by state_ptr into a single
+	///        contiguous image.
+	///
+	/// Every link is stored as the offset of its pointee within the image combined
+	/// with the link's state bits. Objects are placed at offsets aligned to their
+	/// type's alignment so that the state bits never collide with the offsets.
+	class graph_writer {
+	public:
+		/// \brief Creates a graph_writer using the given schema.
+		explicit graph_writer(graph_schema const& schema);
+
+		/// \brief Adds a root object. Everything reachable from roots is written.
+		template<typename T>
+		void add_root(T const* root);
+
+		/// \brief Returns the image of the graph reachable from all roots.
+		auto write() const -> std::vector<char>;
+
+		/// \brief Writes the image of the graph reachable from all roots to the given file.
+		void write_file(std::string const& path) const;
+
+	private:
+		graph_schema const*                                      m_schema;
+		std::vector<std::pair<void const*, std::type_index>>     m_roots;
+	};
+
+	/// \brief An owned graph image, either in memory or mapped from a file.
+	///
+	/// Mapped images use private mappings so that swizzling never writes
+	/// back to the file.
+	class graph_image {
+	public:
+		/// \brief Takes ownership of the given in-memory image.
+		explicit graph_image(std::vector<char> buffer);
+
+		/// \brief Maps the image stored in the given file into memory.
+		///
+		/// Startup is a single mmap; pages are only read on first access.
+		static auto map_file(std::string const& path) -> graph_image;
+
+		graph_image(graph_image&& other) noexcept;
+		graph_image& operator=(graph_image&&) = delete;
+		graph_image(graph_image const&) = delete;
+		graph_image& operator=(graph_image const&) = delete;
+
+		~graph_image();
+
+		/// \brief Returns the start of the image.
+		auto data() noexcept -> char*;
+
+		/// \brief Returns the size of the image in bytes.
+		auto size() const noexcept -> std::size_t;
+
+	private:
+		graph_image() = default;
+
+	private:
+		std::vector<char> m_buffer;
+		char*             m_mapping = nullptr;
+		std::size_t       m_mapping_size = 0;
+	};
+
+	/// \brief Provides access to the objects of a graph image.
+	///
+	/// Links are swizzled lazily: an object's links are turned back from offsets
+	/// into pointers on first access of the object via root or follow. Objects
+	/// that are never accessed are never touched.
+	///
+	/// Note: Not thread-safe since accessing objects may swizzle them.
+	class graph_reader {
+	public:
+		/// \brief Creates a graph_reader for the given image using the given schema.
+		///
+		/// Throws std::runtime_error if the image is malformed.
+		graph_reader(graph_schema const& schema, graph_image& image);
+
+		/// \brief Returns the number of roots within the image.
+		auto root_count() const noexcept -> std::size_t;
+
+		/// \brief Returns the root with the given index with its links swizzled.
+		///
+		/// Throws std::out_of_range if there is no such root and std::runtime_error
+		/// if the root or its links are malformed or the root is no T.
+		template<typename T>
+		auto root(std::size_t index) -> T*;
+
+		/// \brief Returns the pointee of the given swizzled link with its own links swizzled.
+		///
+		/// Throws std::runtime_error if the links of the pointee are malformed.
+		template<typename U, typename S, std::size_t B, typename P>
+		auto follow(state_ptr<U, S, B, P> const& link) -> U*;
+
+		/// \brief Swizzles all objects of the image.
+		///
+		/// Throws std::runtime_error if any reachable object is malformed.
+		void swizzle_all();
+
+	private:
+		/// \brief Swizzles the links of the object at the given address if not yet done.
+		void ensure_swizzled(void* obj, std::type_index type);
+
+		/// \brief Swizzles the links of the object at the given address of the given
+		///        registered type. Returns `false` if it has already been swizzled.
+		auto swizzle(void* obj, std::uint32_t type) -> bool;
+
+		/// \brief Returns the header of the object at the given address.
+		static auto header_of(void* obj) noexcept -> detail::graph_object_header*;
+
+		/// \brief Returns the object at the given offset after checking that its
+		///        header and its registered type lie within the image and that
+		///        it is properly aligned. Throws std::runtime_error otherwise.
+		auto object_at(std::uint64_t offset) const -> void*;
+
+		/// \brief Returns the offset of the root with the given index.
+		auto root_offset(std::size_t index) const noexcept -> std::uint64_t;
+
+	private:
+		graph_schema const* m_schema;
+		char*               m_base;
+		std::size_t         m_size;
+	};
+
+	/// =======================================================================
+	///  Implementation of graph_schema.
+	/// =======================================================================
+
+	template<typename T, typename U, typename S, std::size_t B, typename P>
+	auto graph_schema::make_link(state_ptr<U, S, B, P> T::* link) -> link_info {
+		using link_type = state_ptr<U, S, B, P>;
+		return link_info{
+			std::type_index{typeid(U)},
+			[link](void const* obj) -> void const* {
+				return (static_cast<T const*>(obj)->*link).get_ptr();
+			},
+			[link](void* obj, std::uint64_t offset) {
+				auto& l = static_cast<T*>(obj)->*link;
+				l = link_type{reinterpret_cast<U*>(static_cast<std::uintptr_t>(offset)), l.get_state()};
+			},
+			[link](void const* obj) -> std::uint64_t {
+				return reinterpret_cast<std::uintptr_t>((static_cast<T const*>(obj)->*link).get_ptr());
+			},
+			[link](void* obj, char* base) {
+				auto& l = static_cast<T*>(obj)->*link;
+				auto const offset = reinterpret_cast<std::uintptr_t>(l.get_ptr());
+				auto const target = offset == 0 ? nullptr : reinterpret_cast<U*>(base + offset);
+				l = link_type{target, l.get_state()};
+			}
+		};
+	}
+
+	template<typename T, typename... Links>
+	auto graph_schema::add(Links T::*... links) -> graph_schema& {
+		static_assert(std::is_trivially_copyable<T>::value, "graph objects must be trivially copyable");
+		m_types.push_back(type_info{
+			std::type_index{typeid(T)},
+			sizeof(T),
+			alignof(T),
+			std::vector<link_info>{make_link(links)...}
+		});
+		return *this;
+	}
+
+	inline auto graph_schema::index_of(std::type_index type) const -> std::uint32_t {
+		for (std::size_t i = 0; i < m_types.size(); ++i) {
+			if (m_types[i].type == type) {
+				return static_cast<std::uint32_t>(i);
+			}
+		}
+		throw std::invalid_argument{"type is not registered in the graph_schema"};
+	}
+
+	/// =======================================================================
+	///  Implementation of graph_writer.
+	/// =======================================================================
+
+	inline graph_writer::graph_writer(graph_schema const& schema) :
+		m_schema{&schema},
+		m_roots{}
+	{}
+
+	template<typename T>
+	void graph_writer::add_root(T const* root) {
+		m_roots.emplace_back(root, std::type_index{typeid(T)});
+	}
+
+	inline auto graph_writer::write() const -> std::vector<char> {
+		struct placement {
+			void const*   obj;
+			std::uint32_t type;
+			std::uint64_t offset;
+		};
+
+		// Assign offsets to all reachable objects in breadth-first order.
+		std::unordered_map<void const*, std::uint64_t> offsets;
+		std::vector<placement> placed;
+		std::deque<std::pair<void const*, std::type_index>> queue{m_roots.begin(), m_roots.end()};
+		auto cursor = sizeof(detail::graph_image_header) + m_roots.size() * sizeof(std::uint64_t);
+		while (!queue.empty()) {
+			auto const obj  = queue.front().first;
+			auto const type = m_schema->index_of(queue.front().second);
+			queue.pop_front();
+			if (obj == nullptr || offsets.count(obj) != 0) {
+				continue;
+			}
+			auto const& info   = m_schema->m_types[type];
+			auto const  align  = info.align > alignof(std::uint64_t) ? info.align : alignof(std::uint64_t);
+			auto const  offset = detail::align_up(cursor + sizeof(detail::graph_object_header), align);
+			offsets.emplace(obj, offset);
+			placed.push_back(placement{obj, type, offset});
+			cursor = offset + info.size;
+			for (auto const& link : info.links) {
+				queue.emplace_back(link.pointee(obj), link.target);
+			}
+		}
+
+		std::vector<char> image(detail::align_up(cursor, alignof(std::uint64_t)), 0);
+		auto const header = detail::graph_image_header{
+			detail::graph_image_magic,
+			detail::graph_image_version,
+			static_cast<std::uint32_t>(m_roots.size()),
+			image.size()
+		};
+		std::memcpy(image.data(), &header, sizeof(header));
+		for (std::size_t i = 0; i < m_roots.size(); ++i) {
+			auto const it     = offsets.find(m_roots[i].first);
+			auto const offset = it == offsets.end() ? std::uint64_t{0} : it->second;
+			std::memcpy(image.data() + sizeof(header) + i * sizeof(offset), &offset, sizeof(offset));
+		}
+		for (auto const& p : placed) {
+			auto const& info = m_schema->m_types[p.type];
+			auto const  dest = image.data() + p.offset;
+			auto const  obj_header = detail::graph_object_header{p.type, 0};
+			std::memcpy(dest - sizeof(obj_header), &obj_header, sizeof(obj_header));
+			std::memcpy(dest, p.obj, info.size);
+			for (auto const& link : info.links) {
+				auto const target = link.pointee(p.obj);
+				link.encode(dest, target == nullptr ? 0 : offsets.at(target));
+			}
+		}
+		return image;
+	}
+
+	inline void graph_writer::write_file(std::string const& path) const {
+		auto const image = write();
+		std::ofstream out{path, std::ios::binary | std::ios::trunc};
+		out.write(image.data(), static_cast<std::streamsize>(image.size()));
+		if (!out) {
+			throw std::runtime_error{"failed to write graph image to " + path};
+		}
+	}
+
+	/// =======================================================================
+	///  Implementation of graph_image.
+	/// =======================================================================
+
+	inline graph_image::graph_image(std::vector<char> buffer) :
+		m_buffer{std::move(buffer)}
+	{}
+
+	inline graph_image::graph_image(graph_image&& other) noexcept :
+		m_buffer{std::move(other.m_buffer)},
+		m_mapping{other.m_mapping},
+		m_mapping_size{other.m_mapping_size}
+	{
+		other.m_mapping      = nullptr;
+		other.m_mapping_size = 0;
+	}
+
+	inline graph_image::~graph_image() {
+#if defined(__unix__) || defined(__APPLE__)
+		if (m_mapping != nullptr) {
+			::munmap(m_mapping, m_mapping_size);
+		}
+#endif
+	}
+
+	inline auto graph_image::map_file(std::string const& path) -> graph_image {
+#if defined(__unix__) || defined(__APPLE__)
+		auto const fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw std::runtime_error{"failed to open graph image " + path};
+		}
+		struct ::stat st;
+		if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+			::close(fd);
+			throw std::runtime_error{"failed to stat graph image " + path};
+		}
+		auto const size = static_cast<std::size_t>(st.st_size);
+		auto const mem  = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (mem == MAP_FAILED) {
+			throw std::runtime_error{"failed to map graph image " + path};
+		}
+		graph_image image;
+		image.m_mapping      = static_cast<char*>(mem);
+		image.m_mapping_size = size;
+		return image;
+#else
+		std::ifstream in{path, std::ios::binary};
+		std::vector<char> buffer{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+		if (!in && !in.eof()) {
+			throw std::runtime_error{"failed to read graph image " + path};
+		}
+		return graph_image{std::move(buffer)};
+#endif
+	}
+
+	inline auto graph_image::data() noexcept -> char* {
+		return m_mapping != nullptr ? m_mapping : m_buffer.data();
+	}
+
+	inline auto graph_image::size() const noexcept -> std::size_t {
+		return m_mapping != nullptr ? m_mapping_size : m_buffer.size();
+	}
+
+	/// =======================================================================
+	///  Implementation of graph_reader.
+	/// =======================================================================
+
+	inline graph_reader::graph_reader(graph_schema const& schema, graph_image& image) :
+		m_schema{&schema},
+		m_base{image.data()},
+		m_size{image.size()}
+	{
+		detail::graph_image_header header;
+		if (m_size < sizeof(header)) {
+			throw std::runtime_error{"graph image is truncated"};
+		}
+		std::memcpy(&header, m_base, sizeof(header));
+		if (header.magic != detail::graph_image_magic || header.version != detail::graph_image_version) {
+			throw std::runtime_error{"not a graph image or unsupported version"};
+		}
+		if (header.size != m_size || sizeof(header) + header.root_count * sizeof(std::uint64_t) > m_size) {
+			throw std::runtime_error{"graph image is truncated"};
+		}
+		if (reinterpret_cast<std::uintptr_t>(m_base) % alignof(std::max_align_t) != 0) {
+			throw std::runtime_error{"graph image is insufficiently aligned"};
+		}
+	}
+
+	inline auto graph_reader::root_count() const noexcept -> std::size_t {
+		detail::graph_image_header header;
+		std::memcpy(&header, m_base, sizeof(header));
+		return header.root_count;
+	}
+
+	inline auto graph_reader::header_of(void* obj) noexcept -> detail::graph_object_header* {
+		return reinterpret_cast<detail::graph_object_header*>(static_cast<char*>(obj) - sizeof(detail::graph_object_header));
+	}
+
+	inline auto graph_reader::root_offset(std::size_t index) const noexcept -> std::uint64_t {
+		std::uint64_t offset;
+		std::memcpy(&offset, m_base + sizeof(detail::graph_image_header) + index * sizeof(offset), sizeof(offset));
+		return offset;
+	}
+
+	inline auto graph_reader::object_at(std::uint64_t offset) const -> void* {
+		// Objects are placed after the roots, preceded by their header, at offsets
+		// aligned to at least the alignment of their header.
+		auto const objects_begin = sizeof(detail::graph_image_header) + root_count() * sizeof(std::uint64_t);
+		if (offset < objects_begin + sizeof(detail::graph_object_header) || offset > m_size) {
+			throw std::runtime_error{"graph object is out of bounds of the image"};
+		}
+		if (offset % alignof(std::uint64_t) != 0) {
+			throw std::runtime_error{"graph object is misaligned"};
+		}
+		auto const obj = m_base + offset;
+		auto const type = header_of(obj)->type;
+		if (type >= m_schema->m_types.size()) {
+			throw std::runtime_error{"graph object has an unknown type"};
+		}
+		auto const& info = m_schema->m_types[type];
+		if (info.size > m_size - offset) {
+			throw std::runtime_error{"graph object is out of bounds of the image"};
+		}
+		if (offset % info.align != 0) {
+			throw std::runtime_error{"graph object is misaligned"};
+		}
+		return obj;
+	}
+
+	inline void graph_reader::ensure_swizzled(void* obj, std::type_index type) {
+		auto const header = header_of(obj);
+		if (header->swizzled == 0) {
+			swizzle(obj, header->type);
+		}
+		if (m_schema->m_types[header->type].type != type) {
+			throw std::runtime_error{"graph object has a different type than expected"};
+		}
+	}
+
+	inline auto graph_reader::swizzle(void* obj, std::uint32_t type) -> bool {
+		auto const header = header_of(obj);
+		if (header->swizzled != 0) {
+			return false;
+		}
+		// Check all links before modifying any so that a malformed object is left untouched.
+		auto const& links = m_schema->m_types[type].links;
+		for (auto const& link : links) {
+			auto const offset = link.offset(obj);
+			if (offset != 0 && m_schema->m_types[header_of(object_at(offset))->type].type != link.target) {
+				throw std::runtime_error{"graph link points to an object of a different type"};
+			}
+		}
+		for (auto const& link : links) {
+			link.swizzle(obj, m_base);
+		}
+		header->swizzled = 1;
+		return true;
+	}
+
+	template<typename T>
+	auto graph_reader::root(std::size_t index) -> T* {
+		if (index >= root_count()) {
+			throw std::out_of_range{"root index is out of bounds"};
+		}
+		auto const offset = root_offset(index);
+		if (offset == 0) {
+			return nullptr;
+		}
+		auto const obj = object_at(offset);
+		ensure_swizzled(obj, std::type_index{typeid(T)});
+		return static_cast<T*>(obj);
+	}
+
+	template<typename U, typename S, std::size_t B, typename P>
+	auto graph_reader::follow(state_ptr<U, S, B, P> const& link) -> U* {
+		auto const target = const_cast<U*>(link.get_ptr());
+		if (target != nullptr) {
+			ensure_swizzled(target, std::type_index{typeid(U)});
+		}
+		return target;
+	}
+
+	inline void graph_reader::swizzle_all() {
+		std::vector<void*> stack;
+		for (std::size_t i = 0; i < root_count(); ++i) {
+			auto const offset = root_offset(i);
+			if (offset != 0) {
+				stack.push_back(object_at(offset));
+			}
+		}
+		while (!stack.empty()) {
+			auto const obj = stack.back();
+			stack.pop_back();
+			auto const type = header_of(obj)->type;
+			if (!swizzle(obj, type)) {
+				continue;
+			}
+			for (auto const& link : m_schema->m_types[type].links) {
+				if (auto const target = link.pointee(obj)) {
+					stack.push_back(const_cast<void*>(target));
+				}
+			}
+		}
+	}
+}
+
+#endif // POINTER_UTILS_GRAPH_IO_HPP
@@ -0,0 +1,303 @@
+#ifndef POINTER_UTILS_HIGH_STATE_PTR_HPP
+#define POINTER_UTILS_HIGH_STATE_PTR_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <cstddef>
+#include <functional>
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	/// \brief A non-owning smart pointer that stores its state in the unused most
+	///        significant bits of the pointer value.
+	///
+	/// On current 64-bit platforms user-space addresses occupy at most the lower
+	/// 48 (or 57 with 5-level paging) bits, so the upper bits are always zero and can
+	/// be used to store a state independently of the alignment of the wrapped type.
+	/// This allows for much wider states than state_ptr, e.g. NUMA node ids,
+	/// lengths or hash fragments.
+	///
+	/// The number of bits is limited to 16 since this is the amount that is
+	/// unused on all common 64-bit platforms with 4-level paging.
+	///
+	/// The interface mirrors the interface of state_ptr.
+	template<typename T,
+	         typename S = std::uintptr_t,
+	         std::size_t state_bits = 16>
+	class high_state_ptr {
+	public:
+		/// \brief The element type.
+		using element_type = T;
+
+		/// \brief Type representing a pointer to an element type.
+		using pointer_type = typename std::add_pointer<T>::type;
+
+		/// \brief Type representing a pointer to a constant element type.
+		using const_pointer_type = typename std::add_pointer<typename std::add_const<T>::type>::type;
+
+		/// \brief Type representing a reference to the element type.
+		using reference_type = typename std::add_lvalue_reference<T>::type;
+
+		/// \brief Type representing a reference to a constant element type.
+		using const_reference_type = typename std::add_lvalue_reference<typename std::add_const<T>::type>::type;
+
+		/// \brief The user defined type used to represent the state.
+		using state_type = S;
+
+		/// \brief The type used internally to store the pointer and the state.
+		using internal_type = std::uintptr_t;
+
+		static_assert(sizeof(internal_type) == 8, "high_state_ptr requires a 64-bit platform.");
+		static_assert(state_bits > 0 && state_bits <= 16, "high_state_ptr supports between 1 and 16 state bits.");
+
+		/// \brief The number of bits reserved for the value of the pointer.
+		constexpr static std::size_t ptr_bits = 8 * sizeof(internal_type) - state_bits;
+
+		/// \brief The maximum value that is possible to be stored as state.
+		constexpr static internal_type state_max = (internal_type{1} << state_bits) - 1u;
+
+		/// \brief The bit-mask to extract the pointer value out of the shared memory.
+		constexpr static internal_type ptr_mask = (internal_type{1} << ptr_bits) - 1u;
+
+		/// \brief The bit-mask to extract the state value out of the shared memory.
+		constexpr static internal_type state_mask = ~ptr_mask;
+
+	public:
+		/// \brief Creates a high_state_ptr instance initialized by a null-pointer and a given state.
+		///
+		/// Panics if the given state is out of bounds of valid state.
+		high_state_ptr(std::nullptr_t, state_type) noexcept;
+
+		/// \brief Creates a high_state_ptr instance pointing to the given pointee and
+		///        initialized with the given state.
+		///
+		/// Panics if the given state is out of bounds of valid state or if
+		/// the upper bits of the given pointer are in use.
+		high_state_ptr(pointer_type ptr, state_type) noexcept;
+
+		high_state_ptr(high_state_ptr const&) = default;
+		high_state_ptr(high_state_ptr&&) = default;
+
+		high_state_ptr& operator=(high_state_ptr const&) noexcept = default;
+		high_state_ptr& operator=(high_state_ptr&&) noexcept = default;
+
+		/// \brief Sets the state value of this high_state_ptr to the given value.
+		///
+		/// Panics if the given state is out of bounds of the valid state space.
+		void set_state(state_type new_state) noexcept;
+
+		/// \brief Returns the current state of this high_state_ptr.
+		auto get_state() const noexcept -> state_type;
+
+		/// \brief Returns the wrapped pointer of this high_state_ptr.
+		auto get_ptr() noexcept -> pointer_type;
+
+		/// \brief Returns the wrapped pointer of this high_state_ptr.
+		auto get_ptr() const noexcept -> const_pointer_type;
+
+		/// \brief Forwards to the wrapped pointer as reference.
+		auto operator*() noexcept -> reference_type;
+
+		/// \brief Forwards to the wrapped pointer as const reference.
+		auto operator*() const noexcept -> const_reference_type;
+
+		/// \brief Forwards to the wrapped pointer.
+		auto operator->() noexcept -> pointer_type;
+
+		/// \brief Forwards to the wrapped const pointer.
+		auto operator->() const noexcept -> const_pointer_type;
+
+		/// \brief Returns false if this high_state_ptr wraps nullptr, and returns true otherwise.
+		explicit operator bool() const noexcept;
+
+		/// \brief Returns `true` if pointer and state of both high_state_ptr are equal.
+		///
+		/// This is a single comparison of the internal words.
+		friend auto operator==(high_state_ptr const& lhs, high_state_ptr const& rhs) noexcept -> bool {
+			return lhs.get_bits() == rhs.get_bits();
+		}
+
+		friend auto operator!=(high_state_ptr const& lhs, high_state_ptr const& rhs) noexcept -> bool {
+			return !(lhs == rhs);
+		}
+
+		friend auto operator==(high_state_ptr const& lhs, std::nullptr_t) noexcept -> bool {
+			return !lhs;
+		}
+
+		friend auto operator!=(high_state_ptr const& lhs, std::nullptr_t) noexcept -> bool {
+			return static_cast<bool>(lhs);
+		}
+
+		friend auto operator==(std::nullptr_t, high_state_ptr const& rhs) noexcept -> bool {
+			return !rhs;
+		}
+
+		friend auto operator!=(std::nullptr_t, high_state_ptr const& rhs) noexcept -> bool {
+			return static_cast<bool>(rhs);
+		}
+
+		friend struct std::hash<high_state_ptr>;
+
+	private:
+		/// \brief Returns the bits representing the pointer value as internal type.
+		constexpr auto get_ptr_bits() const noexcept -> internal_type;
+
+		/// \brief Returns the state value shifted down to the least significant bits.
+		constexpr auto get_state_bits() const noexcept -> internal_type;
+
+		/// \brief Returns the packed representation of pointer and state.
+		///
+		/// This is independent of UTILS_STATE_PTR_SEPARATE_FIELDS.
+		constexpr auto get_bits() const noexcept -> internal_type;
+
+		/// \brief Asserts that the given state is within bounds for the state value.
+		///
+		/// Unlike state_ptr this takes no check policy: the state bits of a
+		/// high_state_ptr do not depend on the alignment of the pointee, so the only
+		/// invalid input is an out-of-range state, which a caller with an
+		/// untrusted state can check against `state_max` itself.
+		static void assert_valid_state(state_type state) noexcept;
+
+	private:
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		internal_type m_ptr;
+		internal_type m_state;
+#else
+		internal_type m_ptr_and_state;
+#endif
+	};
+
+	/// =======================================================================
+	///  Implementation of constructors and member functions.
+	/// =======================================================================
+
+	template<typename T, typename S, std::size_t StateBits>
+	void high_state_ptr<T, S, StateBits>::assert_valid_state(state_type state) noexcept {
+		assert(static_cast<internal_type>(state) <= state_max && "state value is out of bounds for this high_state_ptr");
+		(void)state;
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	high_state_ptr<T, S, StateBits>::high_state_ptr(
+		std::nullptr_t,
+		state_type state
+	) noexcept :
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		m_ptr{0},
+		m_state{0}
+#else
+		m_ptr_and_state{0}
+#endif
+	{
+		set_state(state);
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	high_state_ptr<T, S, StateBits>::high_state_ptr(
+		pointer_type ptr,
+		state_type   state
+	) noexcept :
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		m_ptr{reinterpret_cast<internal_type>(ptr)},
+		m_state{0}
+#else
+		m_ptr_and_state{reinterpret_cast<internal_type>(ptr)}
+#endif
+	{
+		assert((reinterpret_cast<internal_type>(ptr) & state_mask) == 0 && "pointer uses the upper bits reserved for the state");
+		set_state(state);
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	constexpr auto high_state_ptr<T, S, StateBits>::get_ptr_bits() const noexcept -> internal_type {
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		return m_ptr & ptr_mask;
+#else
+		return m_ptr_and_state & ptr_mask;
+#endif
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	constexpr auto high_state_ptr<T, S, StateBits>::get_state_bits() const noexcept -> internal_type {
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		return m_state;
+#else
+		return m_ptr_and_state >> ptr_bits;
+#endif
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	constexpr auto high_state_ptr<T, S, StateBits>::get_bits() const noexcept -> internal_type {
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		return m_ptr | (m_state << ptr_bits);
+#else
+		return m_ptr_and_state;
+#endif
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	void high_state_ptr<T, S, StateBits>::set_state(state_type new_state) noexcept {
+		assert_valid_state(new_state);
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		m_state = static_cast<internal_type>(new_state);
+#else
+		m_ptr_and_state = get_ptr_bits() | (static_cast<internal_type>(new_state) << ptr_bits);
+#endif
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto high_state_ptr<T, S, StateBits>::get_state() const noexcept -> state_type {
+		return static_cast<state_type>(get_state_bits());
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto high_state_ptr<T, S, StateBits>::get_ptr() noexcept -> pointer_type {
+		return reinterpret_cast<pointer_type>(get_ptr_bits());
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto high_state_ptr<T, S, StateBits>::get_ptr() const noexcept -> const_pointer_type {
+		return reinterpret_cast<const_pointer_type>(get_ptr_bits());
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto high_state_ptr<T, S, StateBits>::operator*() const noexcept -> const_reference_type {
+		return *get_ptr();
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto high_state_ptr<T, S, StateBits>::operator*() noexcept -> reference_type {
+		return *get_ptr();
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto high_state_ptr<T, S, StateBits>::operator->() const noexcept -> const_pointer_type {
+		return get_ptr();
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	auto high_state_ptr<T, S, StateBits>::operator->() noexcept -> pointer_type {
+		return get_ptr();
+	}
+
+	template<typename T, typename S, std::size_t StateBits>
+	high_state_ptr<T, S, StateBits>::operator bool() const noexcept {
+		return get_ptr_bits() != 0;
+	}
+}
+
+/// ===========================================================================
+///  Implementation of default std::hash template specialization.
+/// ===========================================================================
+
+namespace std {
+	template<typename T, typename S, size_t StateBits>
+	struct hash<UTILS_STATE_PTR_HPP_NAMESPACE::high_state_ptr<T, S, StateBits>> {
+	public:
+		size_t operator()(UTILS_STATE_PTR_HPP_NAMESPACE::high_state_ptr<T, S, StateBits> const& p) const noexcept {
+			return std::hash<std::uintptr_t>()(p.get_bits());
+		}
+	};
+}
+
+#endif // POINTER_UTILS_HIGH_STATE_PTR_HPP
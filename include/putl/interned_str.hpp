@@ -0,0 +1,360 @@
+#ifndef POINTER_UTILS_INTERNED_STR_HPP
+#define POINTER_UTILS_INTERNED_STR_HPP
+
+#include <putl/high_state_ptr.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	namespace detail {
+		/// \brief The immutable representation of an interned string.
+		///
+		/// The characters are stored directly behind the header and are null-terminated.
+		struct interned_record {
+			std::size_t   length;
+			std::uint64_t hash;
+
+			auto data() const noexcept -> char const* {
+				return reinterpret_cast<char const*>(this + 1);
+			}
+		};
+
+		/// \brief Returns the 64-bit FNV-1a hash of the given characters.
+		inline auto fnv1a(char const* data, std::size_t length) noexcept -> std::uint64_t {
+			std::uint64_t hash = 14695981039346656037ull;
+			for (std::size_t i = 0; i < length; ++i) {
+				hash ^= static_cast<unsigned char>(data[i]);
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+	}
+
+	class interner;
+
+	/// \brief A handle to an interned string that fits into a single pointer.
+	///
+	/// The handle is a high_state_ptr to the interned characters that carries
+	/// the 16 most significant bits of the string's hash in its upper bits.
+	///
+	/// Since equal strings are interned only once, equality is a single word
+	/// comparison and hashing never dereferences. Hash tables probing with raw
+	/// strings can reject most mismatches by comparing hash fragments without
+	/// dereferencing the handle.
+	///
+	/// The default constructed interned_str represents the empty string.
+	class interned_str {
+	public:
+		/// \brief The number of hash bits stored in the handle.
+		constexpr static std::size_t fragment_bits = 16;
+
+		/// \brief Creates a handle to the empty string.
+		interned_str() noexcept;
+
+		/// \brief Returns the null-terminated characters of the interned string.
+		auto c_str() const noexcept -> char const*;
+
+		/// \brief Returns the characters of the interned string.
+		auto data() const noexcept -> char const*;
+
+		/// \brief Returns the number of characters of the interned string.
+		auto size() const noexcept -> std::size_t;
+
+		/// \brief Returns `true` if this is the empty string.
+		auto empty() const noexcept -> bool;
+
+		/// \brief Returns the full 64-bit hash of the interned string.
+		auto hash() const noexcept -> std::uint64_t;
+
+		/// \brief Returns the upper hash bits stored in the handle without dereferencing it.
+		auto hash_fragment() const noexcept -> std::uint16_t;
+
+		/// \brief Returns a copy of the interned string.
+		auto str() const -> std::string;
+
+		/// \brief Returns `true` if both handles refer to the same interned string.
+		///
+		/// This is a single word comparison.
+		friend auto operator==(interned_str const& lhs, interned_str const& rhs) noexcept -> bool {
+			return lhs.m_ptr == rhs.m_ptr;
+		}
+
+		friend auto operator!=(interned_str const& lhs, interned_str const& rhs) noexcept -> bool {
+			return !(lhs == rhs);
+		}
+
+		friend class interner;
+		friend struct std::hash<interned_str>;
+
+	private:
+		using pointer = high_state_ptr<detail::interned_record const, std::uint16_t, fragment_bits>;
+
+		/// \brief Returns the hash fragment stored for the given full hash.
+		constexpr static auto fragment_of(std::uint64_t hash) noexcept -> std::uint16_t {
+			return static_cast<std::uint16_t>(hash >> (64 - fragment_bits));
+		}
+
+		explicit interned_str(detail::interned_record const* record) noexcept;
+
+	private:
+		pointer m_ptr;
+	};
+
+	/// \brief Interns strings so that equal strings are represented by equal interned_str.
+	///
+	/// Interned strings live as long as their interner.
+	///
+	/// Note: Not thread-safe. See concurrent_interner for a thread-safe variant.
+	class interner {
+	public:
+		/// \brief Creates an empty interner.
+		interner();
+
+		interner(interner const&) = delete;
+		interner& operator=(interner const&) = delete;
+
+		/// \brief Returns the interned representation of the given characters.
+		auto intern(char const* data, std::size_t length) -> interned_str;
+
+		/// \brief Returns the interned representation of the given string.
+		auto intern(std::string const& str) -> interned_str;
+
+		/// \brief Returns the interned representation of the given characters
+		///        that have already been hashed with detail::fnv1a.
+		auto intern(char const* data, std::size_t length, std::uint64_t hash) -> interned_str;
+
+		/// \brief Returns the number of distinct non-empty interned strings.
+		auto size() const noexcept -> std::size_t;
+
+	private:
+		/// \brief Copies the given string into the arena and returns its record.
+		auto allocate(char const* data, std::size_t length, std::uint64_t hash) -> detail::interned_record const*;
+
+		/// \brief Doubles the capacity of the lookup table.
+		void grow();
+
+	private:
+		constexpr static std::size_t chunk_size = 64 * 1024;
+
+		std::vector<interned_str>            m_table;
+		std::size_t                          m_size;
+		std::vector<std::unique_ptr<char[]>> m_chunks;
+		char*                                m_chunk_pos;
+		std::size_t                          m_chunk_left;
+	};
+
+	/// \brief A thread-safe interner that is split into independently locked shards.
+	///
+	/// Strings are assigned to shards by their hash so that every string is
+	/// interned exactly once across all shards.
+	class concurrent_interner {
+	public:
+		/// \brief Creates an empty concurrent_interner with the given number of shards.
+		explicit concurrent_interner(std::size_t shards = 16);
+
+		/// \brief Returns the interned representation of the given characters.
+		auto intern(char const* data, std::size_t length) -> interned_str;
+
+		/// \brief Returns the interned representation of the given string.
+		auto intern(std::string const& str) -> interned_str;
+
+		/// \brief Returns the number of distinct non-empty interned strings.
+		auto size() const -> std::size_t;
+
+	private:
+		/// \brief A single independently locked interner.
+		///
+		/// Padded to avoid false sharing of the locks of neighbouring shards.
+		struct shard {
+			mutable std::mutex mutex;
+			interner           strings;
+			char               padding[64];
+		};
+
+	private:
+		std::vector<std::unique_ptr<shard>> m_shards;
+	};
+
+	/// =======================================================================
+	///  Implementation of interned_str.
+	/// =======================================================================
+
+	inline interned_str::interned_str() noexcept :
+		m_ptr{nullptr, 0}
+	{}
+
+	inline interned_str::interned_str(detail::interned_record const* record) noexcept :
+		m_ptr{record, fragment_of(record->hash)}
+	{}
+
+	inline auto interned_str::c_str() const noexcept -> char const* {
+		return m_ptr ? m_ptr->data() : "";
+	}
+
+	inline auto interned_str::data() const noexcept -> char const* {
+		return c_str();
+	}
+
+	inline auto interned_str::size() const noexcept -> std::size_t {
+		return m_ptr ? m_ptr->length : 0;
+	}
+
+	inline auto interned_str::empty() const noexcept -> bool {
+		return !m_ptr;
+	}
+
+	inline auto interned_str::hash() const noexcept -> std::uint64_t {
+		return m_ptr ? m_ptr->hash : detail::fnv1a(nullptr, 0);
+	}
+
+	inline auto interned_str::hash_fragment() const noexcept -> std::uint16_t {
+		return m_ptr.get_state();
+	}
+
+	inline auto interned_str::str() const -> std::string {
+		return std::string(data(), size());
+	}
+
+	/// =======================================================================
+	///  Implementation of interner.
+	/// =======================================================================
+
+	inline interner::interner() :
+		m_table(64),
+		m_size{0},
+		m_chunks{},
+		m_chunk_pos{nullptr},
+		m_chunk_left{0}
+	{}
+
+	inline auto interner::size() const noexcept -> std::size_t {
+		return m_size;
+	}
+
+	inline auto interner::allocate(char const* data, std::size_t length, std::uint64_t hash) -> detail::interned_record const* {
+		constexpr auto align = alignof(detail::interned_record);
+		auto const bytes = (sizeof(detail::interned_record) + length + 1 + align - 1) & ~(align - 1);
+		if (bytes > m_chunk_left) {
+			auto const size = bytes > chunk_size ? bytes : chunk_size;
+			m_chunks.emplace_back(new char[size]);
+			m_chunk_pos  = m_chunks.back().get();
+			m_chunk_left = size;
+		}
+		auto const record = ::new (static_cast<void*>(m_chunk_pos)) detail::interned_record{length, hash};
+		auto const chars  = const_cast<char*>(record->data());
+		std::memcpy(chars, data, length);
+		chars[length] = '\0';
+		m_chunk_pos  += bytes;
+		m_chunk_left -= bytes;
+		return record;
+	}
+
+	inline void interner::grow() {
+		std::vector<interned_str> table(2 * m_table.size());
+		auto const mask = table.size() - 1;
+		for (auto const& s : m_table) {
+			if (!s.empty()) {
+				auto i = static_cast<std::size_t>(s.hash()) & mask;
+				while (!table[i].empty()) {
+					i = (i + 1) & mask;
+				}
+				table[i] = s;
+			}
+		}
+		m_table.swap(table);
+	}
+
+	inline auto interner::intern(char const* data, std::size_t length, std::uint64_t hash) -> interned_str {
+		if (length == 0) {
+			return interned_str{};
+		}
+		auto const fragment = interned_str::fragment_of(hash);
+		auto const mask     = m_table.size() - 1;
+		auto i = static_cast<std::size_t>(hash) & mask;
+		for (; !m_table[i].empty(); i = (i + 1) & mask) {
+			auto const& s = m_table[i];
+			// Only dereference if the hash fragments match.
+			if (s.hash_fragment() == fragment &&
+			    s.size() == length &&
+			    std::memcmp(s.data(), data, length) == 0)
+			{
+				return s;
+			}
+		}
+		auto const result = interned_str{allocate(data, length, hash)};
+		m_table[i] = result;
+		if (++m_size * 2 > m_table.size()) {
+			grow();
+		}
+		return result;
+	}
+
+	inline auto interner::intern(char const* data, std::size_t length) -> interned_str {
+		return intern(data, length, detail::fnv1a(data, length));
+	}
+
+	inline auto interner::intern(std::string const& str) -> interned_str {
+		return intern(str.data(), str.size());
+	}
+
+	/// =======================================================================
+	///  Implementation of concurrent_interner.
+	/// =======================================================================
+
+	inline concurrent_interner::concurrent_interner(std::size_t shards) :
+		m_shards{}
+	{
+		assert(shards > 0 && "concurrent_interner requires at least one shard");
+		m_shards.reserve(shards);
+		for (std::size_t i = 0; i < shards; ++i) {
+			m_shards.emplace_back(new shard{});
+		}
+	}
+
+	inline auto concurrent_interner::intern(char const* data, std::size_t length) -> interned_str {
+		auto const hash = detail::fnv1a(data, length);
+		// The lower hash bits select the table slot within a shard, so use the middle bits.
+		auto& s = *m_shards[static_cast<std::size_t>(hash >> 32) % m_shards.size()];
+		std::lock_guard<std::mutex> lock{s.mutex};
+		return s.strings.intern(data, length, hash);
+	}
+
+	inline auto concurrent_interner::intern(std::string const& str) -> interned_str {
+		return intern(str.data(), str.size());
+	}
+
+	inline auto concurrent_interner::size() const -> std::size_t {
+		std::size_t result = 0;
+		for (auto const& s : m_shards) {
+			std::lock_guard<std::mutex> lock{s->mutex};
+			result += s->strings.size();
+		}
+		return result;
+	}
+}
+
+/// ===========================================================================
+///  Implementation of default std::hash template specialization.
+/// ===========================================================================
+
+namespace std {
+	template<>
+	struct hash<UTILS_STATE_PTR_HPP_NAMESPACE::interned_str> {
+	public:
+		/// \brief Hashes the handle without dereferencing it.
+		///
+		/// Equal strings share the same handle, so hashing the handle is sufficient.
+		size_t operator()(UTILS_STATE_PTR_HPP_NAMESPACE::interned_str const& s) const noexcept {
+			return std::hash<UTILS_STATE_PTR_HPP_NAMESPACE::interned_str::pointer>()(s.m_ptr);
+		}
+	};
+}
+
+#endif // POINTER_UTILS_INTERNED_STR_HPP
@@ -0,0 +1,288 @@
+#ifndef POINTER_UTILS_NUMA_POOL_HPP
+#define POINTER_UTILS_NUMA_POOL_HPP
+
+#include <putl/high_state_ptr.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	namespace detail {
+		/// \brief Returns the number of NUMA nodes of this machine or `1` if unknown.
+		inline auto numa_node_count() noexcept -> std::size_t {
+			std::size_t count = 0;
+#if defined(__linux__)
+			if (auto dir = ::opendir("/sys/devices/system/node")) {
+				while (auto entry = ::readdir(dir)) {
+					unsigned id;
+					char     rest;
+					if (std::sscanf(entry->d_name, "node%u%c", &id, &rest) == 1) {
+						count = std::max(count, std::size_t{id} + 1);
+					}
+				}
+				::closedir(dir);
+			}
+#endif
+			return std::max(count, std::size_t{1});
+		}
+
+		/// \brief Allocates `size` bytes of page-aligned memory that is preferably
+		///        backed by physical memory of the given NUMA node.
+		///
+		/// Binding the memory is best-effort: if the node does not exist (e.g. for
+		/// simulated node counts) or the binding is not permitted (e.g. in containers)
+		/// the memory is allocated without binding.
+		inline auto numa_alloc_on_node(std::size_t size, std::size_t node) -> void* {
+#if defined(__linux__) && defined(SYS_mbind)
+			auto const mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (mem == MAP_FAILED) {
+				throw std::bad_alloc{};
+			}
+			if (node < 8 * sizeof(unsigned long)) {
+				constexpr int mpol_preferred = 1;
+				unsigned long const nodemask = 1ul << node;
+				::syscall(SYS_mbind, mem, size, mpol_preferred, &nodemask, 8 * sizeof(nodemask), 0);
+			}
+			return mem;
+#else
+			(void)node;
+			return ::operator new(size);
+#endif
+		}
+
+		/// \brief Frees memory that has been allocated by numa_alloc_on_node.
+		inline void numa_free(void* mem, std::size_t size) noexcept {
+#if defined(__linux__) && defined(SYS_mbind)
+			::munmap(mem, size);
+#else
+			(void)size;
+			::operator delete(mem);
+#endif
+		}
+	}
+
+	/// \brief A pool of fixed-size objects that keeps a separate free list per NUMA node.
+	///
+	/// Every pointer handed out by the pool is a high_state_ptr that stores the
+	/// home node of the object in its upper bits. Deallocation reads the home
+	/// node directly from the pointer and returns the object to the free list
+	/// of that node, no matter which thread or node frees it, without any
+	/// lookup of the owning chunk.
+	///
+	/// The number of nodes can be given explicitly to simulate NUMA machines
+	/// on machines with fewer nodes.
+	template<typename T, std::size_t node_bits = 8>
+	class numa_pool {
+	public:
+		/// \brief The type of the objects allocated by this pool.
+		using value_type = T;
+
+		/// \brief The type used to represent node ids.
+		using node_type = std::size_t;
+
+		/// \brief Pointer to an object of this pool tagged with its home node.
+		using pointer = high_state_ptr<T, node_type, node_bits>;
+
+		/// \brief The maximum number of nodes supported by this pool.
+		constexpr static std::size_t max_nodes = std::size_t{1} << node_bits;
+
+		/// \brief Creates a pool with one free list per NUMA node of this machine.
+		numa_pool();
+
+		/// \brief Creates a pool with the given number of (possibly simulated) NUMA nodes.
+		///
+		/// `chunk_objects` is the number of objects that are allocated from
+		/// the operating system at once whenever a node runs out of objects.
+		explicit numa_pool(std::size_t nodes, std::size_t chunk_objects = 4096);
+
+		numa_pool(numa_pool const&) = delete;
+		numa_pool& operator=(numa_pool const&) = delete;
+
+		/// \brief Frees all memory of this pool. All objects must have been destroyed.
+		~numa_pool();
+
+		/// \brief Returns the number of nodes of this pool.
+		auto node_count() const noexcept -> std::size_t;
+
+		/// \brief Allocates uninitialized storage for one object on the given node.
+		auto allocate(node_type node) -> pointer;
+
+		/// \brief Returns the given storage to the free list of its home node.
+		void deallocate(pointer p) noexcept;
+
+		/// \brief Allocates and constructs an object on the given node.
+		template<typename... Args>
+		auto create(node_type node, Args&&... args) -> pointer;
+
+		/// \brief Destroys and deallocates the given object.
+		void destroy(pointer p) noexcept;
+
+	private:
+		/// \brief Storage of a single object that is threaded into the free list when unused.
+		union slot {
+			slot*                                                    next;
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+		};
+
+		/// \brief The free list and the allocated chunks of a single node.
+		///
+		/// Padded to avoid false sharing between nodes.
+		struct node_arena {
+			std::mutex                                 mutex;
+			slot*                                      free_list = nullptr;
+			std::vector<std::pair<void*, std::size_t>> chunks;
+			char                                       padding[64];
+		};
+
+		/// \brief Allocates a new chunk for the given node and threads it into its free list.
+		///
+		/// The lock of the node's arena must be held.
+		void refill(node_arena& arena, node_type node);
+
+	private:
+		std::unique_ptr<node_arena[]> m_arenas;
+		std::size_t                   m_nodes;
+		std::size_t                   m_chunk_objects;
+	};
+
+	/// \brief Reorders the given range of node-tagged pointers so that all pointers
+	///        with the same home node are adjacent and ordered by node id.
+	///
+	/// Returns `node_count + 1` offsets where the pointers of node `i` are
+	/// located in `[first + offsets[i], first + offsets[i + 1])`. This allows
+	/// to hand each part of a work list to workers running on the respective node.
+	/// Uses a counting sort that is stable with respect to the original order.
+	/// All node states must be less than `node_count`.
+	template<typename RandomIt>
+	auto partition_by_node(RandomIt first, RandomIt last, std::size_t node_count) -> std::vector<std::size_t>;
+
+	/// =======================================================================
+	///  Implementation of numa_pool.
+	/// =======================================================================
+
+	template<typename T, std::size_t B>
+	numa_pool<T, B>::numa_pool() :
+		numa_pool{detail::numa_node_count()}
+	{}
+
+	template<typename T, std::size_t B>
+	numa_pool<T, B>::numa_pool(std::size_t nodes, std::size_t chunk_objects) :
+		m_arenas{new node_arena[nodes]},
+		m_nodes{nodes},
+		m_chunk_objects{chunk_objects}
+	{
+		assert(nodes > 0 && nodes <= max_nodes && "node count is not representable by this numa_pool");
+		assert(chunk_objects > 0 && "numa_pool requires a non-zero chunk size");
+	}
+
+	template<typename T, std::size_t B>
+	numa_pool<T, B>::~numa_pool() {
+		for (std::size_t i = 0; i < m_nodes; ++i) {
+			for (auto const& chunk : m_arenas[i].chunks) {
+				detail::numa_free(chunk.first, chunk.second);
+			}
+		}
+	}
+
+	template<typename T, std::size_t B>
+	auto numa_pool<T, B>::node_count() const noexcept -> std::size_t {
+		return m_nodes;
+	}
+
+	template<typename T, std::size_t B>
+	void numa_pool<T, B>::refill(node_arena& arena, node_type node) {
+		auto const size  = m_chunk_objects * sizeof(slot);
+		auto const slots = static_cast<slot*>(detail::numa_alloc_on_node(size, node));
+		arena.chunks.emplace_back(slots, size);
+		for (std::size_t i = 0; i < m_chunk_objects; ++i) {
+			slots[i].next = i + 1 < m_chunk_objects ? &slots[i + 1] : arena.free_list;
+		}
+		arena.free_list = slots;
+	}
+
+	template<typename T, std::size_t B>
+	auto numa_pool<T, B>::allocate(node_type node) -> pointer {
+		assert(node < m_nodes && "node id is out of bounds for this numa_pool");
+		auto& arena = m_arenas[node];
+		std::lock_guard<std::mutex> lock{arena.mutex};
+		if (arena.free_list == nullptr) {
+			refill(arena, node);
+		}
+		auto const s = arena.free_list;
+		arena.free_list = s->next;
+		return pointer{reinterpret_cast<T*>(s), node};
+	}
+
+	template<typename T, std::size_t B>
+	void numa_pool<T, B>::deallocate(pointer p) noexcept {
+		auto& arena = m_arenas[p.get_state()];
+		auto const s = reinterpret_cast<slot*>(p.get_ptr());
+		std::lock_guard<std::mutex> lock{arena.mutex};
+		s->next = arena.free_list;
+		arena.free_list = s;
+	}
+
+	template<typename T, std::size_t B>
+	template<typename... Args>
+	auto numa_pool<T, B>::create(node_type node, Args&&... args) -> pointer {
+		auto p = allocate(node);
+		try {
+			::new (static_cast<void*>(p.get_ptr())) T(std::forward<Args>(args)...);
+		}
+		catch (...) {
+			deallocate(p);
+			throw;
+		}
+		return p;
+	}
+
+	template<typename T, std::size_t B>
+	void numa_pool<T, B>::destroy(pointer p) noexcept {
+		p->~T();
+		deallocate(p);
+	}
+
+	/// =======================================================================
+	///  Implementation of partition_by_node.
+	/// =======================================================================
+
+	template<typename RandomIt>
+	auto partition_by_node(RandomIt first, RandomIt last, std::size_t node_count) -> std::vector<std::size_t> {
+		using value_type = typename std::iterator_traits<RandomIt>::value_type;
+		std::vector<std::size_t> offsets(node_count + 1, 0);
+		for (auto it = first; it != last; ++it) {
+			assert(static_cast<std::size_t>(it->get_state()) < node_count && "node state is out of bounds for partition_by_node");
+			++offsets[static_cast<std::size_t>(it->get_state()) + 1];
+		}
+		for (std::size_t i = 1; i <= node_count; ++i) {
+			offsets[i] += offsets[i - 1];
+		}
+		std::vector<value_type> sorted;
+		sorted.reserve(static_cast<std::size_t>(last - first));
+		for (auto it = first; it != last; ++it) {
+			sorted.push_back(*it);
+		}
+		auto cursors = offsets;
+		for (auto const& p : sorted) {
+			first[static_cast<std::ptrdiff_t>(cursors[static_cast<std::size_t>(p.get_state())]++)] = p;
+		}
+		return offsets;
+	}
+}
+
+#endif // POINTER_UTILS_NUMA_POOL_HPP
@@ -0,0 +1,142 @@
+#ifndef POINTER_UTILS_OPTIONAL_REF_HPP
+#define POINTER_UTILS_OPTIONAL_REF_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <cstddef>
+#include <type_traits>
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	/// \brief A pointer-sized optional pointer that distinguishes "absent" from
+	///        "present but null".
+	///
+	/// This is a replacement for `std::optional<T*>` that occupies a single word
+	/// and is trivially copyable, so it is returned in a register.
+	///
+	/// "Absent" is represented by a null-pointer with its lowest bit set. For
+	/// element types with an alignment of at least 2 this is the null-pointer with
+	/// a state of `1`, for other types it is the address `1` which can never refer
+	/// to an object either. Checking for presence is thus a single comparison.
+	template<typename T>
+	class optional_ref {
+	public:
+		/// \brief Type representing a pointer to an element type.
+		using pointer_type = typename std::add_pointer<T>::type;
+
+		/// \brief The state_ptr used to represent the optional pointer.
+		using storage_type = state_ptr<T, std::uintptr_t, (alignof(T) > 1 ? 1 : 0)>;
+
+		/// \brief Creates an absent optional_ref.
+		optional_ref() noexcept;
+
+		/// \brief Creates a present optional_ref holding the given pointer which may be null.
+		optional_ref(pointer_type ptr) noexcept;
+
+		/// \brief Creates a present optional_ref pointing to the given reference.
+		optional_ref(T& ref) noexcept;
+
+		optional_ref(optional_ref const&) = default;
+		optional_ref& operator=(optional_ref const&) = default;
+
+		/// \brief Returns `true` if a (possibly null) pointer is present.
+		auto has_value() const noexcept -> bool;
+
+		/// \brief Returns `true` if a (possibly null) pointer is present.
+		explicit operator bool() const noexcept;
+
+		/// \brief Returns the present pointer.
+		///
+		/// Panics if assertions are enabled and no pointer is present.
+		auto value() const noexcept -> pointer_type;
+
+		/// \brief Returns the present pointer or the given fallback if there is none.
+		auto value_or(pointer_type fallback) const noexcept -> pointer_type;
+
+		/// \brief Returns the present pointer.
+		///
+		/// Panics if assertions are enabled and no pointer is present.
+		auto operator*() const noexcept -> pointer_type;
+
+		/// \brief Makes this optional_ref absent.
+		void reset() noexcept;
+
+		/// \brief Returns `true` if both are absent or both hold the same pointer.
+		friend auto operator==(optional_ref const& lhs, optional_ref const& rhs) noexcept -> bool {
+			return lhs.m_ptr == rhs.m_ptr;
+		}
+
+		friend auto operator!=(optional_ref const& lhs, optional_ref const& rhs) noexcept -> bool {
+			return !(lhs == rhs);
+		}
+
+	private:
+		/// \brief Returns the representation of an absent optional_ref.
+		static auto absent() noexcept -> storage_type;
+
+	private:
+		storage_type m_ptr;
+	};
+
+	/// =======================================================================
+	///  Implementation of optional_ref.
+	/// =======================================================================
+
+	template<typename T>
+	auto optional_ref<T>::absent() noexcept -> storage_type {
+		return alignof(T) > 1
+			? storage_type{nullptr, 1}
+			: storage_type{reinterpret_cast<pointer_type>(std::uintptr_t{1}), 0};
+	}
+
+	template<typename T>
+	optional_ref<T>::optional_ref() noexcept :
+		m_ptr{absent()}
+	{
+#if !UTILS_STATE_PTR_SEPARATE_FIELDS
+		static_assert(sizeof(optional_ref) == sizeof(pointer_type), "optional_ref must be pointer-sized.");
+#endif
+	}
+
+	template<typename T>
+	optional_ref<T>::optional_ref(pointer_type ptr) noexcept :
+		m_ptr{ptr, 0}
+	{}
+
+	template<typename T>
+	optional_ref<T>::optional_ref(T& ref) noexcept :
+		m_ptr{std::addressof(ref), 0}
+	{}
+
+	template<typename T>
+	auto optional_ref<T>::has_value() const noexcept -> bool {
+		return m_ptr != absent();
+	}
+
+	template<typename T>
+	optional_ref<T>::operator bool() const noexcept {
+		return has_value();
+	}
+
+	template<typename T>
+	auto optional_ref<T>::value() const noexcept -> pointer_type {
+		assert(has_value() && "accessed the value of an absent optional_ref");
+		return const_cast<pointer_type>(m_ptr.get_ptr());
+	}
+
+	template<typename T>
+	auto optional_ref<T>::value_or(pointer_type fallback) const noexcept -> pointer_type {
+		return has_value() ? const_cast<pointer_type>(m_ptr.get_ptr()) : fallback;
+	}
+
+	template<typename T>
+	auto optional_ref<T>::operator*() const noexcept -> pointer_type {
+		return value();
+	}
+
+	template<typename T>
+	void optional_ref<T>::reset() noexcept {
+		m_ptr = absent();
+	}
+}
+
+#endif // POINTER_UTILS_OPTIONAL_REF_HPP
@@ -0,0 +1,259 @@
+#ifndef POINTER_UTILS_PACKED48_VECTOR_HPP
+#define POINTER_UTILS_PACKED48_VECTOR_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#define UTILS_PACKED48_HAS_SSSE3_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	namespace detail {
+		/// \brief The number of state bits used by packed48_vector by default:
+		///        as many as state_ptr uses by default, but at most 3.
+		template<typename T, typename S>
+		constexpr auto packed48_default_bits() noexcept -> std::size_t {
+			return default_state_bits<T, S>() < 3 ? default_state_bits<T, S>() : 3;
+		}
+
+		/// \brief Decodes `count` little-endian 48-bit words starting at `src` into `out`.
+		inline void unpack48_scalar(unsigned char const* src, std::size_t count, std::uint64_t* out) noexcept {
+			for (std::size_t i = 0; i < count; ++i) {
+				std::uint64_t word = 0;
+				std::memcpy(&word, src + 6 * i, 6);
+				out[i] = word;
+			}
+		}
+
+#if defined(UTILS_PACKED48_HAS_SSSE3_KERNEL)
+		/// \brief Decodes `count` 48-bit words using SSSE3 byte shuffles, four words at a time.
+		///
+		/// Requires 16 readable bytes past the last full group of four words.
+		__attribute__((target("ssse3")))
+		inline void unpack48_ssse3(unsigned char const* src, std::size_t count, std::uint64_t* out) noexcept {
+			auto const shuffle = _mm_setr_epi8(0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, 11, -1, -1);
+			std::size_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				auto const lo = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 6 * i));
+				auto const hi = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 6 * i + 12));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),     _mm_shuffle_epi8(lo, shuffle));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 2), _mm_shuffle_epi8(hi, shuffle));
+			}
+			unpack48_scalar(src + 6 * i, count - i, out + i);
+		}
+#endif
+
+		/// \brief Decodes `count` 48-bit words using the fastest kernel supported by this CPU.
+		inline void unpack48(unsigned char const* src, std::size_t count, std::uint64_t* out) noexcept {
+#if defined(UTILS_PACKED48_HAS_SSSE3_KERNEL)
+			static bool const has_ssse3 = __builtin_cpu_supports("ssse3");
+			if (has_ssse3) {
+				return unpack48_ssse3(src, count, out);
+			}
+#endif
+			unpack48_scalar(src, count, out);
+		}
+	}
+
+	/// \brief A vector of state_ptr that stores every element in only 6 bytes.
+	///
+	/// User-space addresses on current 64-bit platforms fit into 48 bits. The
+	/// remaining state bits are taken from the alignment of T just like state_ptr
+	/// does. Elements are stored as unaligned little-endian 48-bit words, which
+	/// saves 25% of memory compared to `std::vector<state_ptr<T>>`. Elements are
+	/// encoded and decoded by copying the first 6 bytes of a 64-bit word which
+	/// requires a little-endian platform.
+	///
+	/// Random access decodes a single element with an unaligned load. Streaming
+	/// scans should use decode which uses SIMD kernels where available.
+	template<typename T,
+	         typename S = std::uintptr_t,
+	         std::size_t state_bits = detail::packed48_default_bits<T, S>()>
+	class packed48_vector {
+	public:
+		/// \brief The type of the decoded elements.
+		using value_type = state_ptr<T, S, state_bits>;
+
+		/// \brief The user defined type used to represent the state.
+		using state_type = S;
+
+		/// \brief The number of bytes used to store a single element.
+		constexpr static std::size_t element_bytes = 6;
+
+		static_assert(sizeof(std::uintptr_t) == 8, "packed48_vector requires a 64-bit platform.");
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+		static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "packed48_vector requires a little-endian platform.");
+#endif
+
+		/// \brief Creates an empty packed48_vector.
+		packed48_vector();
+
+		/// \brief Returns the number of elements.
+		auto size() const noexcept -> std::size_t;
+
+		/// \brief Returns `true` if there are no elements.
+		auto empty() const noexcept -> bool;
+
+		/// \brief Returns the number of bytes occupied by the elements.
+		auto memory_bytes() const noexcept -> std::size_t;
+
+		/// \brief Reserves storage for at least the given number of elements.
+		void reserve(std::size_t count);
+
+		/// \brief Removes all elements.
+		void clear() noexcept;
+
+		/// \brief Appends the given element.
+		///
+		/// Throws std::invalid_argument if the pointer does not fit into 48 bits
+		/// in which case the vector is left unchanged.
+		void push_back(value_type const& p);
+
+		/// \brief Returns the element at the given index.
+		auto operator[](std::size_t index) const noexcept -> value_type;
+
+		/// \brief Replaces the element at the given index.
+		///
+		/// Throws std::invalid_argument if the pointer does not fit into 48 bits
+		/// in which case the element is left unchanged.
+		void set(std::size_t index, value_type const& p);
+
+		/// \brief Decodes `count` elements starting at `first` into `out`.
+		void decode(std::size_t first, std::size_t count, value_type* out) const noexcept;
+
+		/// \brief Calls `f` with every element in order, decoding them in blocks.
+		template<typename F>
+		void for_each(F&& f) const;
+
+	private:
+		/// \brief Encodes the given element into its 48-bit representation.
+		///
+		/// Throws std::invalid_argument if it does not fit into 48 bits.
+		static auto encode(value_type const& p) -> std::uint64_t;
+
+		/// \brief Decodes the given 48-bit representation into an element.
+		static auto decode_word(std::uint64_t word) noexcept -> value_type;
+
+		/// \brief Number of padding bytes behind the last element so that all
+		///        kernels may read full 16-byte blocks.
+		constexpr static std::size_t padding = 16;
+
+		/// \brief Number of elements decoded at once by bulk operations.
+		constexpr static std::size_t block_size = 256;
+
+		/// \brief The mask of all bits used within a word.
+		constexpr static std::uint64_t word_mask = (std::uint64_t{1} << 48) - 1u;
+
+	private:
+		std::vector<unsigned char> m_bytes;
+		std::size_t                m_size;
+	};
+
+	/// =======================================================================
+	///  Implementation of packed48_vector.
+	/// =======================================================================
+
+	template<typename T, typename S, std::size_t B>
+	packed48_vector<T, S, B>::packed48_vector() :
+		m_bytes(padding, 0),
+		m_size{0}
+	{}
+
+	template<typename T, typename S, std::size_t B>
+	auto packed48_vector<T, S, B>::size() const noexcept -> std::size_t {
+		return m_size;
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto packed48_vector<T, S, B>::empty() const noexcept -> bool {
+		return m_size == 0;
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto packed48_vector<T, S, B>::memory_bytes() const noexcept -> std::size_t {
+		return m_bytes.capacity();
+	}
+
+	template<typename T, typename S, std::size_t B>
+	void packed48_vector<T, S, B>::reserve(std::size_t count) {
+		m_bytes.reserve(count * element_bytes + padding);
+	}
+
+	template<typename T, typename S, std::size_t B>
+	void packed48_vector<T, S, B>::clear() noexcept {
+		m_bytes.assign(padding, 0);
+		m_size = 0;
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto packed48_vector<T, S, B>::encode(value_type const& p) -> std::uint64_t {
+		auto const word = static_cast<std::uint64_t>(p.raw());
+		if (word > word_mask) {
+			throw std::invalid_argument{"pointer does not fit into 48 bits"};
+		}
+		return word;
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto packed48_vector<T, S, B>::decode_word(std::uint64_t word) noexcept -> value_type {
+		return value_type::from_raw(static_cast<std::uintptr_t>(word));
+	}
+
+	template<typename T, typename S, std::size_t B>
+	void packed48_vector<T, S, B>::push_back(value_type const& p) {
+		auto const word = encode(p);
+		m_bytes.resize(m_bytes.size() + element_bytes, 0);
+		std::memcpy(m_bytes.data() + m_size * element_bytes, &word, element_bytes);
+		++m_size;
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto packed48_vector<T, S, B>::operator[](std::size_t index) const noexcept -> value_type {
+		assert(index < m_size && "index is out of bounds");
+		std::uint64_t word;
+		std::memcpy(&word, m_bytes.data() + index * element_bytes, sizeof(word));
+		return decode_word(word & word_mask);
+	}
+
+	template<typename T, typename S, std::size_t B>
+	void packed48_vector<T, S, B>::set(std::size_t index, value_type const& p) {
+		assert(index < m_size && "index is out of bounds");
+		auto const word = encode(p);
+		std::memcpy(m_bytes.data() + index * element_bytes, &word, element_bytes);
+	}
+
+	template<typename T, typename S, std::size_t B>
+	void packed48_vector<T, S, B>::decode(std::size_t first, std::size_t count, value_type* out) const noexcept {
+		assert(first + count <= m_size && "range is out of bounds");
+		std::uint64_t words[block_size];
+		for (std::size_t done = 0; done < count; done += block_size) {
+			auto const n = count - done < block_size ? count - done : block_size;
+			detail::unpack48(m_bytes.data() + (first + done) * element_bytes, n, words);
+			for (std::size_t i = 0; i < n; ++i) {
+				out[done + i] = decode_word(words[i]);
+			}
+		}
+	}
+
+	template<typename T, typename S, std::size_t B>
+	template<typename F>
+	void packed48_vector<T, S, B>::for_each(F&& f) const {
+		std::uint64_t words[block_size];
+		for (std::size_t first = 0; first < m_size; first += block_size) {
+			auto const n = m_size - first < block_size ? m_size - first : block_size;
+			detail::unpack48(m_bytes.data() + first * element_bytes, n, words);
+			for (std::size_t i = 0; i < n; ++i) {
+				f(decode_word(words[i]));
+			}
+		}
+	}
+}
+
+#endif // POINTER_UTILS_PACKED48_VECTOR_HPP
@@ -0,0 +1,42 @@
+#ifndef POINTER_UTILS_PREFETCH_HPP
+#define POINTER_UTILS_PREFETCH_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <cstddef>
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	/// \brief Follows up to `k` links of a linked structure from `first`,
+	///        prefetches every link it reaches and returns the last one.
+	///
+	/// `next` maps a link to its successor, e.g. `[](node_ptr p) { return p->next; }`.
+	/// Links are state_ptr or anything else with a `prefetch(prefetch_locality)`
+	/// member and an explicit conversion to `bool`; the state bits are stripped
+	/// by state_ptr::prefetch before the hint is issued. `first` itself is
+	/// dereferenced but not prefetched. Following stops early at a null link.
+	///
+	/// The returned link is prefetched without being dereferenced, so its load
+	/// overlaps with whatever the caller does until it follows that link. Every
+	/// other reached link is dereferenced by the next hop right after its hint,
+	/// which hides no latency: within a single call the hops of a pointer chase
+	/// remain serialized.
+	template<typename P, typename Next>
+	auto prefetch_chain(P first, std::size_t k, Next next, prefetch_locality locality = prefetch_locality::high) -> P;
+
+	/// =======================================================================
+	///  Implementation of prefetch_chain.
+	/// =======================================================================
+
+	template<typename P, typename Next>
+	auto prefetch_chain(P first, std::size_t k, Next next, prefetch_locality locality) -> P {
+		for (std::size_t i = 0; i < k && static_cast<bool>(first); ++i) {
+			first = next(first);
+			if (static_cast<bool>(first)) {
+				first.prefetch(locality);
+			}
+		}
+		return first;
+	}
+}
+
+#endif // POINTER_UTILS_PREFETCH_HPP
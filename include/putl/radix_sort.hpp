@@ -0,0 +1,243 @@
+#ifndef POINTER_UTILS_RADIX_SORT_HPP
+#define POINTER_UTILS_RADIX_SORT_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	namespace detail {
+		/// \brief Provides the number of state bits of a state_ptr type.
+		template<typename P>
+		struct radix_state_ptr_traits;
+
+		template<typename T, typename S, std::size_t B, typename C>
+		struct radix_state_ptr_traits<state_ptr<T, S, B, C>> {
+			using value_type = state_ptr<T, S, B, C>;
+			using state_type = S;
+			constexpr static std::size_t state_bits = B;
+		};
+
+		/// \brief The number of key bits sorted by a single radix pass.
+		constexpr unsigned radix_digit_bits = 8;
+
+		/// \brief The number of buckets of a single radix pass.
+		constexpr std::size_t radix_buckets = std::size_t{1} << radix_digit_bits;
+
+		/// \brief Returns the digit of the given word that starts at bit `shift`
+		///        and ends before bit `end`.
+		inline auto radix_digit(std::uint64_t word, unsigned shift, unsigned end) noexcept -> std::size_t {
+			auto const bits = end - shift < radix_digit_bits ? end - shift : radix_digit_bits;
+			return static_cast<std::size_t>((word >> shift) & ((std::uint64_t{1} << bits) - 1u));
+		}
+
+		/// \brief Calls `f(chunk, first, last)` for `chunks` equally sized chunks
+		///        of `[0, count)` on separate threads and waits for all of them.
+		template<typename F>
+		void radix_for_chunks(std::size_t chunks, std::size_t count, F const& f) {
+			std::vector<std::thread> workers;
+			workers.reserve(chunks - 1);
+			for (std::size_t c = 1; c < chunks; ++c) {
+				workers.emplace_back([&f, c, chunks, count] {
+					f(c, count * c / chunks, count * (c + 1) / chunks);
+				});
+			}
+			f(std::size_t{0}, std::size_t{0}, count / chunks);
+			for (auto& worker : workers) {
+				worker.join();
+			}
+		}
+
+		/// \brief Stably sorts `words` by the bits `[lo, hi)` using `tmp` as scratch space.
+		///
+		/// Passes for digits that are equal in all words are skipped which is
+		/// common for the upper bits of clustered addresses. The sorted words
+		/// end up in `words`.
+		inline void radix_sort_words(
+			std::vector<std::uint64_t>& words,
+			std::vector<std::uint64_t>& tmp,
+			unsigned                    lo,
+			unsigned                    hi
+		) {
+			auto const count  = words.size();
+			auto const passes = (hi - lo + radix_digit_bits - 1) / radix_digit_bits;
+			// All histograms are permutation-invariant so they are computed in a single pass upfront.
+			std::vector<std::size_t> histograms(passes * radix_buckets, 0);
+			for (auto const word : words) {
+				for (unsigned p = 0; p < passes; ++p) {
+					auto const shift = lo + p * radix_digit_bits;
+					++histograms[p * radix_buckets + radix_digit(word, shift, hi)];
+				}
+			}
+			for (unsigned p = 0; p < passes; ++p) {
+				auto const shift     = lo + p * radix_digit_bits;
+				auto const histogram = histograms.data() + p * radix_buckets;
+				if (std::find(histogram, histogram + radix_buckets, count) != histogram + radix_buckets) {
+					continue;
+				}
+				std::size_t offsets[radix_buckets];
+				std::size_t sum = 0;
+				for (std::size_t d = 0; d < radix_buckets; ++d) {
+					offsets[d] = sum;
+					sum       += histogram[d];
+				}
+				for (auto const word : words) {
+					tmp[offsets[radix_digit(word, shift, hi)]++] = word;
+				}
+				words.swap(tmp);
+			}
+		}
+
+		/// \brief Same as radix_sort_words but histograms and scatters on `threads` threads.
+		inline void parallel_radix_sort_words(
+			std::vector<std::uint64_t>& words,
+			std::vector<std::uint64_t>& tmp,
+			unsigned                    lo,
+			unsigned                    hi,
+			std::size_t                 threads
+		) {
+			auto const count  = words.size();
+			auto const chunks = std::max<std::size_t>(1, std::min(threads, count / 4096));
+			std::vector<std::size_t> offsets(chunks * radix_buckets);
+			for (auto shift = lo; shift < hi; shift += radix_digit_bits) {
+				std::fill(offsets.begin(), offsets.end(), 0);
+				radix_for_chunks(chunks, count, [&](std::size_t c, std::size_t first, std::size_t last) {
+					auto const histogram = offsets.data() + c * radix_buckets;
+					for (auto i = first; i < last; ++i) {
+						++histogram[radix_digit(words[i], shift, hi)];
+					}
+				});
+				// Turn the per-chunk histograms into per-chunk scatter offsets:
+				// every chunk writes its words of a digit behind those of the preceding chunks.
+				std::size_t sum     = 0;
+				bool        trivial = false;
+				for (std::size_t d = 0; d < radix_buckets; ++d) {
+					auto const before = sum;
+					for (std::size_t c = 0; c < chunks; ++c) {
+						auto const n = offsets[c * radix_buckets + d];
+						offsets[c * radix_buckets + d] = sum;
+						sum += n;
+					}
+					trivial = trivial || sum - before == count;
+				}
+				if (trivial) {
+					continue;
+				}
+				radix_for_chunks(chunks, count, [&](std::size_t c, std::size_t first, std::size_t last) {
+					auto const chunk_offsets = offsets.data() + c * radix_buckets;
+					for (auto i = first; i < last; ++i) {
+						tmp[chunk_offsets[radix_digit(words[i], shift, hi)]++] = words[i];
+					}
+				});
+				words.swap(tmp);
+			}
+		}
+
+		/// \brief Copies the words of the given state_ptr range into a vector.
+		template<typename RandomIt>
+		auto radix_load_words(RandomIt first, RandomIt last) -> std::vector<std::uint64_t> {
+			std::vector<std::uint64_t> words;
+			words.reserve(static_cast<std::size_t>(std::distance(first, last)));
+			for (; first != last; ++first) {
+				words.push_back(static_cast<std::uint64_t>((*first).raw()));
+			}
+			return words;
+		}
+
+		/// \brief Stores the given words back into the given state_ptr range.
+		template<typename RandomIt>
+		void radix_store_words(std::vector<std::uint64_t> const& words, RandomIt first) {
+			using value_type = typename std::iterator_traits<RandomIt>::value_type;
+			for (auto const word : words) {
+				*first = value_type::from_raw(static_cast<std::uintptr_t>(word));
+				++first;
+			}
+		}
+
+		/// \brief Returns the bucket boundaries of the given words sorted by state.
+		inline auto radix_state_buckets(std::vector<std::uint64_t> const& words, std::size_t state_bits) -> std::vector<std::size_t> {
+			auto const mask = (std::uint64_t{1} << state_bits) - 1u;
+			std::vector<std::size_t> buckets((std::size_t{1} << state_bits) + 1, 0);
+			for (auto const word : words) {
+				++buckets[static_cast<std::size_t>(word & mask) + 1];
+			}
+			std::partial_sum(buckets.begin(), buckets.end(), buckets.begin());
+			return buckets;
+		}
+
+		/// \brief Returns the number of threads to use for the given request.
+		inline auto radix_threads(std::size_t requested) noexcept -> std::size_t {
+			if (requested != 0) {
+				return requested;
+			}
+			auto const hardware = static_cast<std::size_t>(std::thread::hardware_concurrency());
+			return hardware != 0 ? hardware : 1;
+		}
+	}
+
+	/// \brief Sorts the given range of state_ptr by their pointer bits only.
+	///
+	/// This is a stable LSD radix sort on the bits above the state bits, so
+	/// elements with equal addresses keep their relative order regardless of
+	/// their states. Processing a work list in address order touches every
+	/// page only once and greatly reduces TLB misses.
+	template<typename RandomIt>
+	void sort_by_address(RandomIt first, RandomIt last) {
+		using traits = detail::radix_state_ptr_traits<typename std::iterator_traits<RandomIt>::value_type>;
+		auto words = detail::radix_load_words(first, last);
+		std::vector<std::uint64_t> tmp(words.size());
+		detail::radix_sort_words(words, tmp, traits::state_bits, 64);
+		detail::radix_store_words(words, first);
+	}
+
+	/// \brief Sorts the given range of state_ptr by their state and then by their address.
+	///
+	/// Returns `2^state_bits + 1` bucket boundaries: the elements with state `s`
+	/// are found in `[first + buckets[s], first + buckets[s + 1])`, each bucket
+	/// sorted by address.
+	template<typename RandomIt>
+	auto bucket_by_state(RandomIt first, RandomIt last) -> std::vector<std::size_t> {
+		using traits = detail::radix_state_ptr_traits<typename std::iterator_traits<RandomIt>::value_type>;
+		auto words = detail::radix_load_words(first, last);
+		std::vector<std::uint64_t> tmp(words.size());
+		// LSD: sorting by the address first and stably by the state last yields state-major order.
+		detail::radix_sort_words(words, tmp, traits::state_bits, 64);
+		detail::radix_sort_words(words, tmp, 0, traits::state_bits);
+		detail::radix_store_words(words, first);
+		return detail::radix_state_buckets(words, traits::state_bits);
+	}
+
+	/// \brief Same as sort_by_address but sorts on the given number of threads.
+	///
+	/// A thread count of `0` uses all hardware threads.
+	template<typename RandomIt>
+	void parallel_sort_by_address(RandomIt first, RandomIt last, std::size_t threads = 0) {
+		using traits = detail::radix_state_ptr_traits<typename std::iterator_traits<RandomIt>::value_type>;
+		auto words = detail::radix_load_words(first, last);
+		std::vector<std::uint64_t> tmp(words.size());
+		detail::parallel_radix_sort_words(words, tmp, traits::state_bits, 64, detail::radix_threads(threads));
+		detail::radix_store_words(words, first);
+	}
+
+	/// \brief Same as bucket_by_state but sorts on the given number of threads.
+	///
+	/// A thread count of `0` uses all hardware threads.
+	template<typename RandomIt>
+	auto parallel_bucket_by_state(RandomIt first, RandomIt last, std::size_t threads = 0) -> std::vector<std::size_t> {
+		using traits = detail::radix_state_ptr_traits<typename std::iterator_traits<RandomIt>::value_type>;
+		auto words = detail::radix_load_words(first, last);
+		std::vector<std::uint64_t> tmp(words.size());
+		detail::parallel_radix_sort_words(words, tmp, traits::state_bits, 64, detail::radix_threads(threads));
+		detail::parallel_radix_sort_words(words, tmp, 0, traits::state_bits, detail::radix_threads(threads));
+		detail::radix_store_words(words, first);
+		return detail::radix_state_buckets(words, traits::state_bits);
+	}
+}
+
+#endif // POINTER_UTILS_RADIX_SORT_HPP
@@ -0,0 +1,344 @@
+#ifndef POINTER_UTILS_SORTED_STATE_PTR_ARRAY_HPP
+#define POINTER_UTILS_SORTED_STATE_PTR_ARRAY_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	namespace detail {
+		/// \brief Returns the `width` bits wide value with the given position
+		///        out of a bit-packed sequence.
+		///
+		/// Requires one readable word behind the last word holding packed bits
+		/// unless `width` is zero.
+		inline auto unpack_bits_at(std::uint64_t const* src, unsigned width, std::size_t index) noexcept -> std::uint64_t {
+			if (width == 0) {
+				return 0;
+			}
+			auto const bit   = index * width;
+			auto const word  = bit / 64;
+			auto const shift = static_cast<unsigned>(bit % 64);
+			auto const mask  = width == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << width) - 1u;
+			// Shifting in two steps avoids the undefined shift by 64 for `shift == 0`.
+			auto const lo = src[word] >> shift;
+			auto const hi = (src[word + 1] << 1) << (63 - shift);
+			return (lo | hi) & mask;
+		}
+
+		/// \brief Unpacks `count` values of a compile-time width and adds `base` to each.
+		///
+		/// With the width known at compile time the shifts and masks become
+		/// constants which allows the compiler to unroll and vectorize the loop.
+		template<unsigned Width>
+		void unpack_bits_fixed(std::uint64_t const* src, std::size_t count, std::uint64_t base, std::uint64_t* out) noexcept {
+			for (std::size_t i = 0; i < count; ++i) {
+				out[i] = base + unpack_bits_at(src, Width, i);
+			}
+		}
+
+		template<>
+		inline void unpack_bits_fixed<0>(std::uint64_t const*, std::size_t count, std::uint64_t base, std::uint64_t* out) noexcept {
+			std::fill(out, out + count, base);
+		}
+
+		using unpack_bits_fn = void (*)(std::uint64_t const*, std::size_t, std::uint64_t, std::uint64_t*);
+
+		template<std::size_t... Widths>
+		auto unpack_bits_kernel(unsigned width, std::index_sequence<Widths...>) noexcept -> unpack_bits_fn {
+			static constexpr unpack_bits_fn kernels[] = {&unpack_bits_fixed<static_cast<unsigned>(Widths)>...};
+			return kernels[width];
+		}
+
+		/// \brief Unpacks `count` values of the given width and adds `base` to each.
+		inline void unpack_bits(std::uint64_t const* src, unsigned width, std::size_t count, std::uint64_t base, std::uint64_t* out) noexcept {
+			assert(width <= 64 && "bit width is out of bounds");
+			unpack_bits_kernel(width, std::make_index_sequence<65>{})(src, count, base, out);
+		}
+
+		/// \brief Appends `count` values of the given width to the bit-packed sequence `dst`.
+		inline void pack_bits(std::uint64_t const* values, std::size_t count, unsigned width, std::vector<std::uint64_t>& dst) {
+			auto const first = dst.size();
+			dst.resize(first + (count * width + 63) / 64, 0);
+			if (width == 0) {
+				return;
+			}
+			for (std::size_t i = 0; i < count; ++i) {
+				auto const bit   = i * width;
+				auto const word  = first + bit / 64;
+				auto const shift = static_cast<unsigned>(bit % 64);
+				dst[word] |= values[i] << shift;
+				if (shift + width > 64) {
+					dst[word + 1] |= values[i] >> (64 - shift);
+				}
+			}
+		}
+	}
+
+	/// \brief An immutable, compressed array of state_ptr sorted by address.
+	///
+	/// Elements are split into blocks of `block_size` elements. Each block is
+	/// frame-of-reference coded: it stores its first word as base and all
+	/// elements as bit-packed offsets from the base using as many bits as the
+	/// largest offset in the block requires. The states are part of the
+	/// encoded words, so they are kept alongside the addresses for free.
+	///
+	/// For address-clustered arrays this requires a fraction of the memory of
+	/// `std::vector<state_ptr<T>>`. Random access decodes a single offset and
+	/// lookups by address skip whole blocks by their bases.
+	template<typename T,
+	         typename S = std::uintptr_t,
+	         std::size_t state_bits = detail::default_state_bits<T, S>()>
+	class sorted_state_ptr_array {
+	public:
+		/// \brief The type of the decoded elements.
+		using value_type = state_ptr<T, S, state_bits>;
+
+		/// \brief Type representing a pointer to an element type.
+		using pointer_type = typename std::add_pointer<T>::type;
+
+		/// \brief The user defined type used to represent the state.
+		using state_type = S;
+
+		/// \brief The number of elements per block.
+		constexpr static std::size_t block_size = 128;
+
+		/// \brief Creates an empty sorted_state_ptr_array.
+		sorted_state_ptr_array();
+
+		/// \brief Creates a sorted_state_ptr_array holding the given elements.
+		///
+		/// Panics if the elements are not sorted by address and state.
+		template<typename InputIt>
+		sorted_state_ptr_array(InputIt first, InputIt last);
+
+		/// \brief Returns the number of elements.
+		auto size() const noexcept -> std::size_t;
+
+		/// \brief Returns `true` if there are no elements.
+		auto empty() const noexcept -> bool;
+
+		/// \brief Returns the number of blocks.
+		auto block_count() const noexcept -> std::size_t;
+
+		/// \brief Returns the number of bytes occupied by the encoded elements and block headers.
+		auto memory_bytes() const noexcept -> std::size_t;
+
+		/// \brief Returns the element at the given index.
+		auto operator[](std::size_t index) const noexcept -> value_type;
+
+		/// \brief Decodes all elements of the given block into `out`
+		///        and returns the number of decoded elements.
+		///
+		/// `out` must have room for `block_size` elements.
+		auto decode_block(std::size_t block, value_type* out) const noexcept -> std::size_t;
+
+		/// \brief Returns the index of the first element whose address is not less than `ptr`.
+		auto lower_bound(pointer_type ptr) const noexcept -> std::size_t;
+
+		/// \brief Returns the index of the first element with the given address or `size()` if there is none.
+		auto find(pointer_type ptr) const noexcept -> std::size_t;
+
+		/// \brief Returns `true` if an element with the given address exists.
+		auto contains(pointer_type ptr) const noexcept -> bool;
+
+		/// \brief Calls `f` with every element in order, decoding them block by block.
+		template<typename F>
+		void for_each(F&& f) const;
+
+	private:
+		/// \brief Returns the encoded word of the given element.
+		static auto encode(value_type const& p) noexcept -> std::uint64_t;
+
+		/// \brief Returns the element represented by the given encoded word.
+		static auto decode_word(std::uint64_t word) noexcept -> value_type;
+
+		/// \brief Returns the encoded word of the element at the given index.
+		auto word_at(std::size_t index) const noexcept -> std::uint64_t;
+
+		/// \brief Frame-of-reference encodes the given words as a new block.
+		void append_block(std::uint64_t const* words, std::size_t count);
+
+	private:
+		/// \brief The first encoded word of every block.
+		std::vector<std::uint64_t> m_bases;
+
+		/// \brief The index of the first packed word of every block within m_data.
+		std::vector<std::size_t> m_offsets;
+
+		/// \brief The bit width of the offsets of every block.
+		std::vector<std::uint8_t> m_widths;
+
+		/// \brief The bit-packed offsets of all blocks followed by one padding word.
+		std::vector<std::uint64_t> m_data;
+
+		std::size_t m_size;
+	};
+
+	/// =======================================================================
+	///  Implementation of sorted_state_ptr_array.
+	/// =======================================================================
+
+	template<typename T, typename S, std::size_t B>
+	sorted_state_ptr_array<T, S, B>::sorted_state_ptr_array() :
+		m_bases{},
+		m_offsets{},
+		m_widths{},
+		m_data(1, 0),
+		m_size{0}
+	{}
+
+	template<typename T, typename S, std::size_t B>
+	template<typename InputIt>
+	sorted_state_ptr_array<T, S, B>::sorted_state_ptr_array(InputIt first, InputIt last) :
+		sorted_state_ptr_array{}
+	{
+		std::uint64_t words[block_size];
+		std::size_t   count = 0;
+		for (; first != last; ++first) {
+			words[count] = encode(*first);
+			assert((count > 0 ? words[count - 1] : m_bases.empty() ? 0 : word_at(m_size - 1)) <= words[count] &&
+				"elements of sorted_state_ptr_array must be sorted by address and state");
+			if (++count == block_size) {
+				append_block(words, count);
+				count = 0;
+			}
+		}
+		if (count > 0) {
+			append_block(words, count);
+		}
+		m_data.shrink_to_fit();
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto sorted_state_ptr_array<T, S, B>::encode(value_type const& p) noexcept -> std::uint64_t {
+		return static_cast<std::uint64_t>(p.raw());
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto sorted_state_ptr_array<T, S, B>::decode_word(std::uint64_t word) noexcept -> value_type {
+		return value_type::from_raw(static_cast<std::uintptr_t>(word));
+	}
+
+	template<typename T, typename S, std::size_t B>
+	void sorted_state_ptr_array<T, S, B>::append_block(std::uint64_t const* words, std::size_t count) {
+		auto const base = words[0];
+		std::uint64_t offsets[block_size];
+		for (std::size_t i = 0; i < count; ++i) {
+			offsets[i] = words[i] - base;
+		}
+		// Elements are sorted so the last offset is the largest.
+		auto const width = detail::bit_width(offsets[count - 1]);
+		// Drop the padding word and append it again after the new block.
+		m_data.pop_back();
+		m_bases.push_back(base);
+		m_offsets.push_back(m_data.size());
+		m_widths.push_back(static_cast<std::uint8_t>(width));
+		detail::pack_bits(offsets, count, width, m_data);
+		m_data.push_back(0);
+		m_size += count;
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto sorted_state_ptr_array<T, S, B>::size() const noexcept -> std::size_t {
+		return m_size;
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto sorted_state_ptr_array<T, S, B>::empty() const noexcept -> bool {
+		return m_size == 0;
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto sorted_state_ptr_array<T, S, B>::block_count() const noexcept -> std::size_t {
+		return m_bases.size();
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto sorted_state_ptr_array<T, S, B>::memory_bytes() const noexcept -> std::size_t {
+		return m_bases.capacity() * sizeof(std::uint64_t)
+		     + m_offsets.capacity() * sizeof(std::size_t)
+		     + m_widths.capacity() * sizeof(std::uint8_t)
+		     + m_data.capacity() * sizeof(std::uint64_t);
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto sorted_state_ptr_array<T, S, B>::word_at(std::size_t index) const noexcept -> std::uint64_t {
+		auto const block = index / block_size;
+		return m_bases[block] + detail::unpack_bits_at(
+			m_data.data() + m_offsets[block], m_widths[block], index % block_size);
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto sorted_state_ptr_array<T, S, B>::operator[](std::size_t index) const noexcept -> value_type {
+		assert(index < m_size && "index is out of bounds");
+		return decode_word(word_at(index));
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto sorted_state_ptr_array<T, S, B>::decode_block(std::size_t block, value_type* out) const noexcept -> std::size_t {
+		assert(block < block_count() && "block is out of bounds");
+		auto const count = block + 1 < block_count() ? block_size : m_size - block * block_size;
+		std::uint64_t words[block_size];
+		detail::unpack_bits(m_data.data() + m_offsets[block], m_widths[block], count, m_bases[block], words);
+		for (std::size_t i = 0; i < count; ++i) {
+			out[i] = decode_word(words[i]);
+		}
+		return count;
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto sorted_state_ptr_array<T, S, B>::lower_bound(pointer_type ptr) const noexcept -> std::size_t {
+		// States are smaller than the alignment, so the plain address is not
+		// greater than any word with the same address.
+		auto const key = reinterpret_cast<std::uint64_t>(ptr);
+		// Skip all blocks that start with a smaller address than the key.
+		auto const next = std::lower_bound(m_bases.begin(), m_bases.end(), key);
+		if (next == m_bases.begin()) {
+			return 0;
+		}
+		auto const block = static_cast<std::size_t>(std::distance(m_bases.begin(), next)) - 1;
+		auto first = block * block_size;
+		auto last  = block + 1 < block_count() ? first + block_size : m_size;
+		while (first < last) {
+			auto const mid = first + (last - first) / 2;
+			if (word_at(mid) < key) {
+				first = mid + 1;
+			} else {
+				last = mid;
+			}
+		}
+		return first;
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto sorted_state_ptr_array<T, S, B>::find(pointer_type ptr) const noexcept -> std::size_t {
+		auto const index = lower_bound(ptr);
+		return index < m_size && (*this)[index].get_ptr() == ptr ? index : m_size;
+	}
+
+	template<typename T, typename S, std::size_t B>
+	auto sorted_state_ptr_array<T, S, B>::contains(pointer_type ptr) const noexcept -> bool {
+		return find(ptr) != m_size;
+	}
+
+	template<typename T, typename S, std::size_t B>
+	template<typename F>
+	void sorted_state_ptr_array<T, S, B>::for_each(F&& f) const {
+		std::uint64_t words[block_size];
+		for (std::size_t block = 0; block < block_count(); ++block) {
+			auto const count = block + 1 < block_count() ? block_size : m_size - block * block_size;
+			detail::unpack_bits(m_data.data() + m_offsets[block], m_widths[block], count, m_bases[block], words);
+			for (std::size_t i = 0; i < count; ++i) {
+				f(decode_word(words[i]));
+			}
+		}
+	}
+}
+
+#endif // POINTER_UTILS_SORTED_STATE_PTR_ARRAY_HPP
@@ -0,0 +1,327 @@
+#ifndef POINTER_UTILS_STATE_INDEX_HPP
+#define POINTER_UTILS_STATE_INDEX_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	/// \brief An index into a container that stores an additional state alongside
+	///        the index value within a single 32-bit or 64-bit word.
+	///
+	/// This is the index-based counterpart of state_ptr: indices stay valid when
+	/// the container reallocates and a 32-bit state_index is half the size of a
+	/// pointer. The state occupies the `state_bits` least significant bits and
+	/// the index occupies the remaining bits of the word.
+	///
+	/// All operations are constexpr and the type is trivially copyable, so it
+	/// may be relocated with memcpy.
+	template<typename Container,
+	         typename S = std::uintptr_t,
+	         std::size_t state_bits = 2,
+	         typename Word = std::uint32_t>
+	class state_index {
+	public:
+		/// \brief The container type that is indexed.
+		using container_type = Container;
+
+		/// \brief Type representing a reference to an element of the container.
+		using reference_type = decltype(std::declval<Container&>()[std::size_t{}]);
+
+		/// \brief Type representing a reference to an element of the constant container.
+		using const_reference_type = decltype(std::declval<Container const&>()[std::size_t{}]);
+
+		/// \brief The user defined type used to represent the state.
+		using state_type = S;
+
+		/// \brief The type used internally to store the index and the state.
+		using internal_type = Word;
+
+		static_assert(std::is_unsigned<Word>::value, "The word type of state_index must be an unsigned integer.");
+		static_assert(state_bits < 8 * sizeof(Word), "Too many state bits requested for the word type.");
+
+		/// \brief The number of bits reserved for the value of the index.
+		constexpr static std::size_t index_bits = 8 * sizeof(Word) - state_bits;
+
+		/// \brief The maximum value that is possible to be stored as state.
+		constexpr static internal_type state_max = static_cast<internal_type>((internal_type{1} << state_bits) - 1u);
+
+		/// \brief The bit-mask to extract the state value out of the shared word.
+		constexpr static internal_type state_mask = state_max;
+
+		/// \brief The greatest representable index. It is reserved for null indices.
+		constexpr static std::size_t max_index = static_cast<std::size_t>(static_cast<internal_type>(~internal_type{0}) >> state_bits);
+
+	public:
+		/// \brief Creates a state_index referring to index `0` with a zero state.
+		constexpr state_index() noexcept;
+
+		/// \brief Creates a state_index referring to the given index with the given state.
+		///
+		/// Panics if the index or the state is out of bounds.
+		constexpr state_index(std::size_t index, state_type state) noexcept;
+
+		/// \brief Returns a state_index that refers to no element with the given state.
+		constexpr static auto null(state_type state = state_type{}) noexcept -> state_index;
+
+		/// \brief Creates a state_index from its internal representation.
+		constexpr static auto from_raw(internal_type raw) noexcept -> state_index;
+
+		/// \brief Returns the internal representation.
+		constexpr auto raw() const noexcept -> internal_type;
+
+		/// \brief Returns `true` if this state_index refers to no element.
+		constexpr auto is_null() const noexcept -> bool;
+
+		/// \brief Returns the wrapped index.
+		constexpr auto get_index() const noexcept -> std::size_t;
+
+		/// \brief Sets the wrapped index while keeping the state.
+		constexpr void set_index(std::size_t index) noexcept;
+
+		/// \brief Returns the current state.
+		constexpr auto get_state() const noexcept -> state_type;
+
+		/// \brief Sets the state while keeping the index.
+		///
+		/// Panics if the given state is out of bounds.
+		constexpr void set_state(state_type new_state) noexcept;
+
+		/// \brief Returns the element of the given container that is referred to by this index.
+		constexpr auto get(container_type& container) const -> reference_type;
+
+		/// \brief Returns the element of the given container that is referred to by this index.
+		constexpr auto get(container_type const& container) const -> const_reference_type;
+
+		friend constexpr auto operator==(state_index const& lhs, state_index const& rhs) noexcept -> bool {
+			return lhs.m_index_and_state == rhs.m_index_and_state;
+		}
+
+		friend constexpr auto operator!=(state_index const& lhs, state_index const& rhs) noexcept -> bool {
+			return !(lhs == rhs);
+		}
+
+	private:
+		internal_type m_index_and_state;
+	};
+
+	/// \brief An atomic cell holding a state_index.
+	///
+	/// Like atomic_state_ptr this provides fetch_or_state and fetch_and_state
+	/// that only touch the state bits with a single read-modify-write.
+	template<typename Container,
+	         typename S = std::uintptr_t,
+	         std::size_t state_bits = 2,
+	         typename Word = std::uint32_t>
+	class atomic_state_index {
+	public:
+		/// \brief The state_index type stored in this atomic cell.
+		using value_type = state_index<Container, S, state_bits, Word>;
+
+		/// \brief The user defined type used to represent the state.
+		using state_type = S;
+
+		/// \brief Creates an atomic_state_index referring to index `0` with a zero state.
+		constexpr atomic_state_index() noexcept;
+
+		/// \brief Creates an atomic_state_index initialized by the given state_index.
+		constexpr atomic_state_index(value_type desired) noexcept;
+
+		atomic_state_index(atomic_state_index const&) = delete;
+		atomic_state_index& operator=(atomic_state_index const&) = delete;
+
+		/// \brief Atomically loads the stored state_index.
+		auto load(std::memory_order order = std::memory_order_seq_cst) const noexcept -> value_type;
+
+		/// \brief Atomically replaces the stored state_index.
+		void store(value_type desired, std::memory_order order = std::memory_order_seq_cst) noexcept;
+
+		/// \brief Atomically replaces the stored state_index and returns the previous one.
+		auto exchange(value_type desired, std::memory_order order = std::memory_order_seq_cst) noexcept -> value_type;
+
+		/// \brief Atomically replaces the stored state_index by `desired` if it equals `expected`.
+		///        Otherwise loads the stored value into `expected`.
+		auto compare_exchange_weak(
+			value_type&       expected,
+			value_type        desired,
+			std::memory_order order = std::memory_order_seq_cst
+		) noexcept -> bool;
+
+		/// \brief Same as compare_exchange_weak but does not fail spuriously.
+		auto compare_exchange_strong(
+			value_type&       expected,
+			value_type        desired,
+			std::memory_order order = std::memory_order_seq_cst
+		) noexcept -> bool;
+
+		/// \brief Atomically ORs the given bits into the state and returns the previous state.
+		auto fetch_or_state(state_type bits, std::memory_order order = std::memory_order_seq_cst) noexcept -> state_type;
+
+		/// \brief Atomically ANDs the given bits into the state and returns the previous state.
+		auto fetch_and_state(state_type bits, std::memory_order order = std::memory_order_seq_cst) noexcept -> state_type;
+
+	private:
+		std::atomic<Word> m_index_and_state;
+	};
+
+	/// =======================================================================
+	///  Implementation of state_index.
+	/// =======================================================================
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr state_index<C, S, B, W>::state_index() noexcept :
+		m_index_and_state{0}
+	{}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr state_index<C, S, B, W>::state_index(std::size_t index, state_type state) noexcept :
+		m_index_and_state{0}
+	{
+		set_index(index);
+		set_state(state);
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr auto state_index<C, S, B, W>::null(state_type state) noexcept -> state_index {
+		return state_index{max_index, state};
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr auto state_index<C, S, B, W>::from_raw(internal_type raw) noexcept -> state_index {
+		state_index result{};
+		result.m_index_and_state = raw;
+		return result;
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr auto state_index<C, S, B, W>::raw() const noexcept -> internal_type {
+		return m_index_and_state;
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr auto state_index<C, S, B, W>::is_null() const noexcept -> bool {
+		return get_index() == max_index;
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr auto state_index<C, S, B, W>::get_index() const noexcept -> std::size_t {
+		return static_cast<std::size_t>(m_index_and_state >> B);
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr void state_index<C, S, B, W>::set_index(std::size_t index) noexcept {
+		assert(index <= max_index && "index is out of bounds for this state_index");
+		m_index_and_state = static_cast<internal_type>((static_cast<internal_type>(index) << B) | (m_index_and_state & state_mask));
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr auto state_index<C, S, B, W>::get_state() const noexcept -> state_type {
+		return static_cast<state_type>(m_index_and_state & state_mask);
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr void state_index<C, S, B, W>::set_state(state_type new_state) noexcept {
+		assert(static_cast<std::uintmax_t>(new_state) <= state_max && "state value is out of bounds for this state_index");
+		m_index_and_state = static_cast<internal_type>((m_index_and_state & ~state_mask) | static_cast<internal_type>(new_state));
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr auto state_index<C, S, B, W>::get(container_type& container) const -> reference_type {
+		assert(!is_null() && "dereferenced a null state_index");
+		return container[get_index()];
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr auto state_index<C, S, B, W>::get(container_type const& container) const -> const_reference_type {
+		assert(!is_null() && "dereferenced a null state_index");
+		return container[get_index()];
+	}
+
+	/// =======================================================================
+	///  Implementation of atomic_state_index.
+	/// =======================================================================
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr atomic_state_index<C, S, B, W>::atomic_state_index() noexcept :
+		m_index_and_state{0}
+	{}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	constexpr atomic_state_index<C, S, B, W>::atomic_state_index(value_type desired) noexcept :
+		m_index_and_state{desired.raw()}
+	{}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	auto atomic_state_index<C, S, B, W>::load(std::memory_order order) const noexcept -> value_type {
+		return value_type::from_raw(m_index_and_state.load(order));
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	void atomic_state_index<C, S, B, W>::store(value_type desired, std::memory_order order) noexcept {
+		m_index_and_state.store(desired.raw(), order);
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	auto atomic_state_index<C, S, B, W>::exchange(value_type desired, std::memory_order order) noexcept -> value_type {
+		return value_type::from_raw(m_index_and_state.exchange(desired.raw(), order));
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	auto atomic_state_index<C, S, B, W>::compare_exchange_weak(
+		value_type&       expected,
+		value_type        desired,
+		std::memory_order order
+	) noexcept -> bool {
+		auto raw = expected.raw();
+		auto const success = m_index_and_state.compare_exchange_weak(raw, desired.raw(), order);
+		expected = value_type::from_raw(raw);
+		return success;
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	auto atomic_state_index<C, S, B, W>::compare_exchange_strong(
+		value_type&       expected,
+		value_type        desired,
+		std::memory_order order
+	) noexcept -> bool {
+		auto raw = expected.raw();
+		auto const success = m_index_and_state.compare_exchange_strong(raw, desired.raw(), order);
+		expected = value_type::from_raw(raw);
+		return success;
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	auto atomic_state_index<C, S, B, W>::fetch_or_state(state_type bits, std::memory_order order) noexcept -> state_type {
+		assert(static_cast<std::uintmax_t>(bits) <= value_type::state_max && "state value is out of bounds for this state_index");
+		auto const prev = m_index_and_state.fetch_or(static_cast<W>(bits), order);
+		return static_cast<state_type>(prev & value_type::state_mask);
+	}
+
+	template<typename C, typename S, std::size_t B, typename W>
+	auto atomic_state_index<C, S, B, W>::fetch_and_state(state_type bits, std::memory_order order) noexcept -> state_type {
+		auto const mask = static_cast<W>(static_cast<W>(bits) | static_cast<W>(~value_type::state_mask));
+		auto const prev = m_index_and_state.fetch_and(mask, order);
+		return static_cast<state_type>(prev & value_type::state_mask);
+	}
+}
+
+/// ===========================================================================
+///  Implementation of default std::hash template specialization.
+/// ===========================================================================
+
+namespace std {
+	template<typename C, typename S, size_t StateBits, typename W>
+	struct hash<UTILS_STATE_PTR_HPP_NAMESPACE::state_index<C, S, StateBits, W>> {
+	public:
+		size_t operator()(UTILS_STATE_PTR_HPP_NAMESPACE::state_index<C, S, StateBits, W> const& i) const noexcept {
+			return std::hash<W>()(i.raw());
+		}
+	};
+}
+
+#endif // POINTER_UTILS_STATE_INDEX_HPP
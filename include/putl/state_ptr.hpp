@@ -1,9 +1,27 @@
 #ifndef POINTER_UTILS_STATE_PTR_HPP
 #define POINTER_UTILS_STATE_PTR_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <cassert>
+#include <functional>
 #include <memory>
+#include <stdexcept>
+
+#if __cplusplus >= 202002L
+#include <bit>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+#if defined(__cpp_impl_three_way_comparison) && __cpp_impl_three_way_comparison >= 201907L
+#include <compare>
+#define UTILS_STATE_PTR_HAS_THREE_WAY_COMPARISON 1
+#else
+#define UTILS_STATE_PTR_HAS_THREE_WAY_COMPARISON 0
+#endif
 
 // Users can change the namespace of `state_ptr`.
 // The default namespace is `putl` which stands for "Pointer Utils".
@@ -11,22 +29,330 @@
 #define UTILS_STATE_PTR_HPP_NAMESPACE putl
 #endif
 
+// Users can make `state_ptr` and `high_state_ptr` store the untagged pointer
+// and the state in separate fields by defining this to `1`. The API stays
+// the same but every instance occupies two words. This is meant for debug
+// and sanitizer builds: leak checkers like LeakSanitizer and Valgrind find
+// heap objects only through words holding their untagged addresses.
+// All translation units of a program must agree on this setting.
+#ifndef UTILS_STATE_PTR_SEPARATE_FIELDS
+#define UTILS_STATE_PTR_SEPARATE_FIELDS 0
+#endif
+
 namespace UTILS_STATE_PTR_HPP_NAMESPACE {
 	namespace detail {
-		/// \brief Returns the logarithm to the power of `2` for the given `number`.
+		/// \brief Returns the index of the most significant set bit of the given value.
+		///
+		/// The given value must not be `0`.
+		constexpr auto highest_bit(std::uint64_t value) noexcept -> unsigned {
+#if defined(__GNUC__) || defined(__clang__)
+			return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#elif defined(__cpp_lib_bitops) && __cpp_lib_bitops >= 201907L
+			return 63u - static_cast<unsigned>(std::countl_zero(value));
+#else
+			unsigned index = 0;
+			for (unsigned shift = 32; shift > 0; shift /= 2) {
+				if (value >> shift != 0) {
+					value >>= shift;
+					index  += shift;
+				}
+			}
+			return index;
+#endif
+		}
+
+		/// \brief Returns the index of the least significant set bit of the given value.
+		///
+		/// The given value must not be `0`.
+		constexpr auto lowest_bit(std::uint64_t value) noexcept -> unsigned {
+#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<unsigned>(__builtin_ctzll(value));
+#elif defined(__cpp_lib_bitops) && __cpp_lib_bitops >= 201907L
+			return static_cast<unsigned>(std::countr_zero(value));
+#else
+			return highest_bit(value & (~value + 1u));
+#endif
+		}
+
+		/// \brief Returns the logarithm to the power of `2` for the given `number`
+		///        rounded down.
+		/// 
+		/// This is exact for powers of two and evaluates in constant time.
 		/// 
 		/// Note: Returns `0` for the special case when `number` is `0`.
 		template<typename T>
-		constexpr auto log2(T number) -> T {
-			T acc{0};
-			while (number > 1) {
-				number /= 2;
-				acc += 1;
+		constexpr auto log2(T number) noexcept -> T {
+			return number <= 1 ? T{0} : static_cast<T>(highest_bit(static_cast<std::uint64_t>(number)));
+		}
+
+		/// \brief Returns the number of bits required to represent the given value.
+		constexpr auto bit_width(std::uint64_t value) noexcept -> unsigned {
+			return value == 0 ? 0 : highest_bit(value) + 1;
+		}
+
+		/// \brief Returns `true` if the given value is a power of two.
+		constexpr auto is_power_of_two(std::uint64_t value) noexcept -> bool {
+			return value != 0 && (value & (value - 1)) == 0;
+		}
+
+		/// \brief Returns the given pointer and informs the compiler that it is
+		///        aligned to `Alignment` bytes.
+		///
+		/// This lets the compiler emit aligned loads and stores, e.g. aligned
+		/// vector loads in loops over the pointee.
+		template<std::size_t Alignment, typename P>
+		inline auto assume_aligned(P* ptr) noexcept -> P* {
+			static_assert(is_power_of_two(Alignment), "The alignment must be a power of two.");
+#if defined(__cpp_lib_assume_aligned) && __cpp_lib_assume_aligned >= 201811L
+			return std::assume_aligned<Alignment>(ptr);
+#elif defined(__GNUC__) || defined(__clang__)
+			return static_cast<P*>(__builtin_assume_aligned(ptr, Alignment));
+#elif defined(_MSC_VER)
+			__assume((reinterpret_cast<std::uintptr_t>(ptr) & (Alignment - 1)) == 0);
+			return ptr;
+#else
+			return ptr;
+#endif
+		}
+	}
+
+	/// \brief How long prefetched data is expected to be used, mapping to the
+	///        locality argument of `__builtin_prefetch`.
+	enum class prefetch_locality {
+		/// \brief Used once, need not be left in the cache afterwards.
+		none = 0,
+		low = 1,
+		moderate = 2,
+		/// \brief Left in all levels of the cache.
+		high = 3
+	};
+
+	namespace detail {
+		/// \brief Hints the processor to load the cache line at the given address.
+		///
+		/// Never faults, even for invalid addresses.
+		inline void prefetch(void const* address, prefetch_locality locality) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+			switch (locality) {
+				case prefetch_locality::none:     __builtin_prefetch(address, 0, 0); break;
+				case prefetch_locality::low:      __builtin_prefetch(address, 0, 1); break;
+				case prefetch_locality::moderate: __builtin_prefetch(address, 0, 2); break;
+				case prefetch_locality::high:     __builtin_prefetch(address, 0, 3); break;
+			}
+			// GCC treats __builtin_prefetch as free of side effects, deduces that
+			// wrappers like this one are const and drops calls to them which are
+			// not inlined early. The empty volatile asm emits no code but keeps
+			// the hint alive.
+			__asm__ __volatile__("");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			auto const p = static_cast<char const*>(address);
+			switch (locality) {
+				case prefetch_locality::none:     _mm_prefetch(p, _MM_HINT_NTA); break;
+				case prefetch_locality::low:      _mm_prefetch(p, _MM_HINT_T2);  break;
+				case prefetch_locality::moderate: _mm_prefetch(p, _MM_HINT_T1);  break;
+				case prefetch_locality::high:     _mm_prefetch(p, _MM_HINT_T0);  break;
+			}
+#else
+			static_cast<void>(address);
+			static_cast<void>(locality);
+#endif
+		}
+	}
+
+	/// \brief Returns the number of low pointer bits that are always zero for
+	///        objects aligned to the given alignment.
+	///
+	/// This is the run-time counterpart of the number of state bits that
+	/// state_ptr derives from `alignof(T)`, e.g. for arenas whose alignment is
+	/// chosen at run-time. The given alignment must be a power of two.
+	constexpr auto alignment_bits(std::size_t alignment) noexcept -> std::size_t {
+		assert(detail::is_power_of_two(alignment) && "alignment must be a power of two");
+		return detail::lowest_bit(alignment);
+	}
+
+	/// \brief The kinds of invalid input detected by the check policies of state_ptr.
+	enum class check_error {
+		/// \brief The state value does not fit into the reserved state bits.
+		state_out_of_bounds,
+		/// \brief The pointer is not aligned enough to leave the state bits free.
+		misaligned_pointer
+	};
+
+	/// \brief Check policies that determine how state_ptr validates its input.
+	///
+	/// A check policy provides
+	///
+	///   - `is_noexcept`: `true` if neither `fail` nor `on_transition` ever throws.
+	///   - `should_check()`: returns `true` if the current write shall be validated.
+	///   - `fail(check_error)`: reports a detected error.
+	///
+	/// Optionally a check policy provides
+	///
+	///   - `template<std::size_t StateBits> on_transition(from, to)`: called by
+	///     `set_state` of a state_ptr with `StateBits` state bits with the old
+	///     and the new state value, e.g. to record transition telemetry. The
+	///     number of state bits allows the hook to check at compile-time that
+	///     it handles all states. Policies without it add no code to `set_state`.
+	namespace check_policy {
+		/// \brief Never validates any input.
+		///
+		/// Invalid input results in undefined behaviour.
+		struct unchecked {
+			constexpr static bool is_noexcept = true;
+
+			constexpr static auto should_check() noexcept -> bool {
+				return false;
+			}
+
+			static void fail(check_error) noexcept {}
+		};
+
+		/// \brief Validates all input with assertions.
+		///
+		/// This is the default and costs nothing when `NDEBUG` is defined.
+		struct assertion {
+			constexpr static bool is_noexcept = true;
+
+			constexpr static auto should_check() noexcept -> bool {
+#ifdef NDEBUG
+				return false;
+#else
+				return true;
+#endif
+			}
+
+			static void fail(check_error error) noexcept {
+				switch (error) {
+					case check_error::state_out_of_bounds:
+						assert(false && "state value is out of bounds for this state_ptr");
+						break;
+					case check_error::misaligned_pointer:
+						assert(false && "pointer is not sufficiently aligned for this state_ptr");
+						break;
+				}
+			}
+		};
+
+		/// \brief Validates all input and throws on invalid input.
+		///
+		/// Throws `std::out_of_range` for invalid states and `std::invalid_argument`
+		/// for misaligned pointers.
+		struct exception {
+			constexpr static bool is_noexcept = false;
+
+			constexpr static auto should_check() noexcept -> bool {
+				return true;
+			}
+
+			static void fail(check_error error) {
+				switch (error) {
+					case check_error::state_out_of_bounds:
+						throw std::out_of_range{"state value is out of bounds for this state_ptr"};
+					case check_error::misaligned_pointer:
+						throw std::invalid_argument{"pointer is not sufficiently aligned for this state_ptr"};
+				}
+			}
+		};
+
+		/// \brief Validates only every `N`-th write per thread and reports
+		///        errors with the `Fallback` policy.
+		///
+		/// This allows production builds to detect systematic misuse at the
+		/// cost of a thread-local counter decrement per write.
+		template<std::uint32_t N, typename Fallback = exception>
+		struct sampled {
+			static_assert(N > 0, "The sampling period must be positive.");
+
+			constexpr static bool is_noexcept = Fallback::is_noexcept;
+
+			static auto should_check() noexcept -> bool {
+				static thread_local std::uint32_t countdown = 0;
+				if (countdown == 0) {
+					countdown = N - 1;
+					return true;
+				}
+				--countdown;
+				return false;
+			}
+
+			static void fail(check_error error) noexcept(is_noexcept) {
+				Fallback::fail(error);
 			}
-			return acc;
+		};
+	}
+
+	namespace detail {
+		/// \brief Calls `P::on_transition<StateBits>(from, to)` if the check policy P provides it.
+		template<typename P, std::size_t StateBits>
+		inline auto notify_transition(int, std::uintptr_t from, std::uintptr_t to) noexcept(P::is_noexcept)
+			-> decltype(P::template on_transition<StateBits>(from, to))
+		{
+			return P::template on_transition<StateBits>(from, to);
 		}
+
+		template<typename P, std::size_t StateBits>
+		constexpr void notify_transition(long, std::uintptr_t, std::uintptr_t) noexcept {}
 	}
 
+	/// \brief Describes the value range of a user-defined state type.
+	///
+	/// Specialize this for state enums and provide `max_value`, the greatest
+	/// state value that is ever stored, e.g.
+	///
+	///     template<> struct putl::state_traits<color> {
+	///         constexpr static std::uintptr_t max_value = color::blue;
+	///     };
+	///
+	/// state_ptr then reserves just as many state bits as are required for
+	/// `max_value` by default, and verifies at compile-time that the state type
+	/// fits into the reserved bits instead of checking every state at run-time.
+	/// Specializations promise that no state value exceeds `max_value`.
+	template<typename S>
+	struct state_traits {};
+
+	namespace detail {
+		/// \brief Is `true` if state_traits<S> provides `max_value`.
+		template<typename S, typename = void>
+		struct has_state_max_value : std::false_type {};
+
+		template<typename S>
+		struct has_state_max_value<S, decltype(void(state_traits<S>::max_value))> : std::true_type {};
+
+		/// \brief Returns `state_traits<S>::max_value` if provided and `0` otherwise.
+		template<typename S>
+		constexpr auto state_max_value(std::true_type) noexcept -> std::uint64_t {
+			return static_cast<std::uint64_t>(state_traits<S>::max_value);
+		}
+
+		template<typename S>
+		constexpr auto state_max_value(std::false_type) noexcept -> std::uint64_t {
+			return 0;
+		}
+
+		template<typename T, typename S>
+		constexpr auto default_state_bits(std::true_type) noexcept -> std::size_t {
+			return bit_width(state_max_value<S>(std::true_type{}));
+		}
+
+		template<typename T, typename S>
+		constexpr auto default_state_bits(std::false_type) noexcept -> std::size_t {
+			return log2(alignof(T));
+		}
+
+		/// \brief Returns the default number of state bits of a state_ptr to T
+		///        with state type S.
+		///
+		/// These are just enough bits for `state_traits<S>::max_value` if it is
+		/// provided, and all bits freed by the alignment of T otherwise.
+		template<typename T, typename S>
+		constexpr auto default_state_bits() noexcept -> std::size_t {
+			return default_state_bits<T, S>(has_state_max_value<S>{});
+		}
+	}
+
+	template<typename T, typename S, std::size_t req_state_bits>
+	class atomic_state_ptr;
+
 	/// \brief A non-owning smart pointer that allows for storing an additional space-optimized
 	///        state along the pointer value that is dependend on the wrapped type's alignment.
 	/// 
@@ -41,9 +367,25 @@ namespace UTILS_STATE_PTR_HPP_NAMESPACE {
 	/// 
 	/// Note: It is planned to provide an implementation of an owning_state_ptr in the future.
 	/// 
+	/// The number of state bits defaults to the bits required by the state type
+	/// as described by state_traits, or to all bits freed by the alignment of T
+	/// for state types without state_traits. Narrow state enums leave the
+	/// remaining low bits of the pointer zero.
+	/// 
+	/// The `CheckPolicy` determines how invalid states and misaligned pointers
+	/// are detected, see check_policy.
+	/// 
+	/// All operations that do not convert between pointers and integers are
+	/// constexpr, including state-only construction, states, comparisons and
+	/// hashing. Constructing from a non-null pointer and accessing the pointer
+	/// require `reinterpret_cast` which is not allowed in constant expressions
+	/// in any C++ standard; compile-time tables of tagged references to static
+	/// objects should use state_index instead.
+	/// 
 	template<typename T,
 	         typename S = std::uintptr_t,
-	         std::size_t req_state_bits = detail::log2(alignof(T))>
+	         std::size_t req_state_bits = detail::default_state_bits<T, S>(),
+	         typename CheckPolicy = check_policy::assertion>
 	class state_ptr {
 	public:
 		/// \brief The element type.
@@ -69,14 +411,22 @@ namespace UTILS_STATE_PTR_HPP_NAMESPACE {
 		/// \brief The type used internally to store the pointer and the state.
 		using internal_type = std::uintptr_t;
 
+		/// \brief The policy used to validate states and pointers.
+		using check_policy_type = CheckPolicy;
+
 	private:
 		/// \brief The maximum number of bits that can be reserved to represent
 		///        the state depending on the alignment of the element type.
-		constexpr static std::size_t state_bits_max = detail::log2(alignof(T));
+		///
+		/// Note: This is a function instead of a constant so that T is only required
+		///       to be complete when constructing a state_ptr. This allows for
+		///       self-referential types, e.g. nodes linked by state_ptr.
+		constexpr static auto state_bits_max() noexcept -> std::size_t {
+			return detail::log2(alignof(T));
+		}
 
 		/// \brief The number of bits reserved for the value of the state.
-		constexpr static std::size_t state_bits = std::min(req_state_bits, state_bits_max);
-		static_assert(req_state_bits <= state_bits_max, "The alignment of T is not sufficient to store the requested amount of state bits.");
+		constexpr static std::size_t state_bits = req_state_bits;
 		// static_assert(state_bits > 0, "The alignment of T is not sufficient to store an additional state.");
 
 		/// \brief The number of bits reserved for the value of the pointer.
@@ -86,6 +436,12 @@ namespace UTILS_STATE_PTR_HPP_NAMESPACE {
 		///        with the given amount of bits reserved for the value of the state.
 		constexpr static internal_type state_max  = (1u << state_bits) - 1u;
 
+		/// \brief Is `true` if state_traits bound all values of the state type.
+		constexpr static bool state_is_bounded = detail::has_state_max_value<S>::value;
+
+		static_assert(detail::state_max_value<S>(detail::has_state_max_value<S>{}) <= state_max,
+			"The values of the state type do not fit into the requested amount of state bits.");
+
 		/// \brief The bit-mask to extract the state value out of the shared memory.
 		constexpr static internal_type state_mask = state_bits == 0 ? 0 : (~internal_type{0}) >> ptr_bits;
 
@@ -93,20 +449,52 @@ namespace UTILS_STATE_PTR_HPP_NAMESPACE {
 		constexpr static internal_type ptr_mask   = ~state_mask;
 
 	public:
+		/// \brief Describes the bit layout of the internal representation returned by raw().
+		///
+		/// The state occupies the `state_bits` least significant bits and the
+		/// pointer the remaining `ptr_bits` bits of the word. This is independent
+		/// of UTILS_STATE_PTR_SEPARATE_FIELDS. Requires no complete element type.
+		struct layout {
+			/// \brief The number of bits of the internal representation.
+			constexpr static std::size_t word_bits = 8 * sizeof(internal_type);
+
+			/// \brief The number of bits reserved for the value of the state.
+			constexpr static std::size_t state_bits = state_ptr::state_bits;
+
+			/// \brief The position of the least significant bit of the state.
+			constexpr static std::size_t state_shift = 0;
+
+			/// \brief The number of bits reserved for the value of the pointer.
+			constexpr static std::size_t ptr_bits = state_ptr::ptr_bits;
+
+			/// \brief The position of the least significant bit of the pointer.
+			constexpr static std::size_t ptr_shift = state_bits;
+
+			/// \brief The bit-mask of the state within the internal representation.
+			constexpr static internal_type state_mask = state_ptr::state_mask;
+
+			/// \brief The bit-mask of the pointer within the internal representation.
+			constexpr static internal_type ptr_mask = state_ptr::ptr_mask;
+
+			/// \brief The greatest state value that can be stored.
+			constexpr static internal_type state_max = state_ptr::state_max;
+		};
+
 		/// \brief Creates a state_ptr instance initialized by a null-pointer and a given state.
 		/// 
-		/// Panics if the given state is out of bounds of valid state.
-		constexpr state_ptr(std::nullptr_t, state_type) noexcept;
+		/// Reports an error to the check policy if the given state is out of bounds of valid state.
+		constexpr state_ptr(std::nullptr_t, state_type) noexcept(check_policy_type::is_noexcept);
 
 		/// \brief Creates a state_ptr instance pointing to the given pointee and
 		///        initialized with the given state.
 		/// 
-		/// Panics if the given state is out of bounds of valid state.
-		state_ptr(pointer_type ptr, state_type) noexcept;
+		/// Reports an error to the check policy if the given state is out of bounds
+		/// of valid state or if the given pointer is not sufficiently aligned.
+		state_ptr(pointer_type ptr, state_type) noexcept(check_policy_type::is_noexcept);
 
 		/// \brief Copies the given state_ptr.
-		explicit state_ptr(state_ptr const&) = default;
-		explicit state_ptr(state_ptr&&) = default;
+		state_ptr(state_ptr const&) = default;
+		state_ptr(state_ptr&&) = default;
 
 		state_ptr& operator=(state_ptr const&) noexcept = default;
 		state_ptr& operator=(state_ptr&&) noexcept = default;
@@ -114,19 +502,24 @@ namespace UTILS_STATE_PTR_HPP_NAMESPACE {
 
 		/// \brief Sets the state value of this state_ptr to the given value.
 		/// 
-		/// Note: This panicks if assertions are enabled whenever the given state
-		///       is out of bounds of the valid state space.
-		///       When assertions are disabled this has undefined behaviour in the 
-		///       error case.
-		void set_state(state_type new_state) noexcept;
+		/// Note: A state that is out of bounds of the valid state space is reported
+		///       to the check policy. When the policy does not check the write
+		///       this has undefined behaviour in the error case.
+		constexpr void set_state(state_type new_state) noexcept(check_policy_type::is_noexcept);
 
 		/// \brief Returns the current state of this state_ptr.
-		auto get_state() const noexcept -> state_type;
+		constexpr auto get_state() const noexcept -> state_type;
 
 		/// \brief Returns the wrapped pointer of this state_ptr.
+		///
+		/// The compiler is informed that the result is aligned to `alignof(T)`
+		/// even if fewer state bits are masked off.
 		auto get_ptr() noexcept -> pointer_type;
 
 		/// \brief Returns the wrapped pointer of this state_ptr.
+		///
+		/// The compiler is informed that the result is aligned to `alignof(T)`
+		/// even if fewer state bits are masked off.
 		auto get_ptr() const noexcept -> const_pointer_type;
 
 		/// \brief Forwards to the wrapped pointer as reference.
@@ -141,39 +534,67 @@ namespace UTILS_STATE_PTR_HPP_NAMESPACE {
 		/// \brief Forwards to the wrapped const pointer.
 		auto operator->() const noexcept -> const_pointer_type;
 
-		/// \brief Returns false if this state_ptr wraps nullptr, and returns true otherwise.
-		explicit operator bool() const noexcept;
+		/// \brief Hints the processor to load the pointee into the cache.
+		///
+		/// The state bits are stripped before the hint is issued. This never
+		/// faults, prefetching a null state_ptr has no effect.
+		void prefetch(prefetch_locality locality = prefetch_locality::high) const noexcept;
 
-		template<typename T1, typename S1, std::size_t ReqStateBits>
-		friend bool operator==(state_ptr<T1, S1, ReqStateBits> const&, state_ptr<T1, S1, ReqStateBits> const&) noexcept;
+		/// \brief Returns false if this state_ptr wraps nullptr, and returns true otherwise.
+		constexpr explicit operator bool() const noexcept;
+
+		/// \brief Returns the internal representation of pointer and state as
+		///        described by layout.
+		///
+		/// The word can be handed to C code or stored in shared memory and be
+		/// turned back into a state_ptr with from_raw.
+		constexpr auto raw() const noexcept -> internal_type;
+
+		/// \brief Creates a state_ptr from its internal representation as
+		///        returned by raw().
+		///
+		/// The given word is not validated by the check policy.
+		constexpr static auto from_raw(internal_type raw) noexcept -> state_ptr;
+
+		template<typename T1, typename S1, std::size_t ReqStateBits, typename C1>
+		friend constexpr bool operator==(state_ptr<T1, S1, ReqStateBits, C1> const&, state_ptr<T1, S1, ReqStateBits, C1> const&) noexcept;
 		
-		template<typename T1, typename S1, std::size_t ReqStateBits>
-		friend bool operator!=(state_ptr<T1, S1, ReqStateBits> const&, state_ptr<T1, S1, ReqStateBits> const&) noexcept;
+		template<typename T1, typename S1, std::size_t ReqStateBits, typename C1>
+		friend constexpr bool operator!=(state_ptr<T1, S1, ReqStateBits, C1> const&, state_ptr<T1, S1, ReqStateBits, C1> const&) noexcept;
 
-		template<typename T1, typename S1, std::size_t ReqStateBits>
-		friend bool operator==(state_ptr<T1, S1, ReqStateBits> const&, std::nullptr_t) noexcept;
+		template<typename T1, typename S1, std::size_t ReqStateBits, typename C1>
+		friend constexpr bool operator==(state_ptr<T1, S1, ReqStateBits, C1> const&, std::nullptr_t) noexcept;
 		
-		template<typename T1, typename S1, std::size_t ReqStateBits>
-		friend bool operator!=(state_ptr<T1, S1, ReqStateBits> const&, std::nullptr_t) noexcept;
+		template<typename T1, typename S1, std::size_t ReqStateBits, typename C1>
+		friend constexpr bool operator!=(state_ptr<T1, S1, ReqStateBits, C1> const&, std::nullptr_t) noexcept;
 
-		template<typename T1, typename S1, std::size_t ReqStateBits>
-		friend bool operator==(std::nullptr_t, state_ptr<T1, S1, ReqStateBits> const&) noexcept;
+		template<typename T1, typename S1, std::size_t ReqStateBits, typename C1>
+		friend constexpr bool operator==(std::nullptr_t, state_ptr<T1, S1, ReqStateBits, C1> const&) noexcept;
 		
-		template<typename T1, typename S1, std::size_t ReqStateBits>
-		friend bool operator!=(std::nullptr_t, state_ptr<T1, S1, ReqStateBits> const&) noexcept;
+		template<typename T1, typename S1, std::size_t ReqStateBits, typename C1>
+		friend constexpr bool operator!=(std::nullptr_t, state_ptr<T1, S1, ReqStateBits, C1> const&) noexcept;
 
-		template<typename T1, typename S1, std::size_t ReqStateBits>
-		friend bool operator<(state_ptr<T1, S1, ReqStateBits> const& lhs, state_ptr<T1, S1, ReqStateBits> const& rhs) noexcept;
+		template<typename T1, typename S1, std::size_t ReqStateBits, typename C1>
+		friend constexpr bool operator<(state_ptr<T1, S1, ReqStateBits, C1> const& lhs, state_ptr<T1, S1, ReqStateBits, C1> const& rhs) noexcept;
 		
-		template<typename T1, typename S1, std::size_t ReqStateBits>
-		friend bool operator<=(state_ptr<T1, S1, ReqStateBits> const& lhs, state_ptr<T1, S1, ReqStateBits> const& rhs) noexcept;
+		template<typename T1, typename S1, std::size_t ReqStateBits, typename C1>
+		friend constexpr bool operator<=(state_ptr<T1, S1, ReqStateBits, C1> const& lhs, state_ptr<T1, S1, ReqStateBits, C1> const& rhs) noexcept;
 		
-		template<typename T1, typename S1, std::size_t ReqStateBits>
-		friend bool operator> (state_ptr<T1, S1, ReqStateBits> const& lhs, state_ptr<T1, S1, ReqStateBits> const& rhs) noexcept;
+		template<typename T1, typename S1, std::size_t ReqStateBits, typename C1>
+		friend constexpr bool operator> (state_ptr<T1, S1, ReqStateBits, C1> const& lhs, state_ptr<T1, S1, ReqStateBits, C1> const& rhs) noexcept;
 		
-		template<typename T1, typename S1, std::size_t ReqStateBits>
-		friend bool operator<=(state_ptr<T1, S1, ReqStateBits> const& lhs, state_ptr<T1, S1, ReqStateBits> const& rhs) noexcept;
+		template<typename T1, typename S1, std::size_t ReqStateBits, typename C1>
+		friend constexpr bool operator>=(state_ptr<T1, S1, ReqStateBits, C1> const& lhs, state_ptr<T1, S1, ReqStateBits, C1> const& rhs) noexcept;
+
+#if UTILS_STATE_PTR_HAS_THREE_WAY_COMPARISON
+		template<typename T1, typename S1, std::size_t ReqStateBits, typename C1>
+		friend constexpr auto operator<=>(state_ptr<T1, S1, ReqStateBits, C1> const& lhs, state_ptr<T1, S1, ReqStateBits, C1> const& rhs) noexcept -> std::strong_ordering;
+#endif
 
+		friend struct std::hash<state_ptr>;
+
+		template<typename T1, typename S1, std::size_t ReqStateBits>
+		friend class atomic_state_ptr;
 
 	private:
 		/// \brief Returns the bits representing the pointer value as internal type.
@@ -182,174 +603,294 @@ namespace UTILS_STATE_PTR_HPP_NAMESPACE {
 		/// \brief Returns the bits representing the state value as internal type.
 		constexpr auto get_state_bits() const noexcept -> internal_type;
 
+		/// \brief Replaces pointer and state by the given packed representation.
+		constexpr void set_bits(internal_type bits) noexcept;
+
 		/// \brief Returns `true` if the given state is within valid bounds for the state value.
 		///        This is associated to the reserved bits for the state value.
 		constexpr static bool is_valid_state(state_type) noexcept;
 
-		/// \brief Asserts that the given state is within bounds for the state value.
-		static void assert_valid_state(state_type) noexcept;
+		/// \brief Returns `true` if the given pointer bits leave the state bits free.
+		constexpr static bool is_aligned(internal_type ptr_bits) noexcept;
 
-		/// \brief Asserts that the state of this state_ptr is within bounds.
-		void assert_invariant() const noexcept;
+		/// \brief Validates the given pointer bits and state according to the check policy.
+		constexpr static void check(internal_type ptr_bits, state_type state) noexcept(check_policy_type::is_noexcept);
 
 	private:
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		internal_type m_ptr;
+		internal_type m_state;
+#else
 		internal_type m_ptr_and_state;
+#endif
 	};
 
+	/// =======================================================================
+	///  Definitions of the layout constants.
+	/// =======================================================================
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr std::size_t state_ptr<T, S, StateBits, C>::layout::word_bits;
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr std::size_t state_ptr<T, S, StateBits, C>::layout::state_bits;
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr std::size_t state_ptr<T, S, StateBits, C>::layout::state_shift;
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr std::size_t state_ptr<T, S, StateBits, C>::layout::ptr_bits;
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr std::size_t state_ptr<T, S, StateBits, C>::layout::ptr_shift;
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr std::uintptr_t state_ptr<T, S, StateBits, C>::layout::state_mask;
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr std::uintptr_t state_ptr<T, S, StateBits, C>::layout::ptr_mask;
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr std::uintptr_t state_ptr<T, S, StateBits, C>::layout::state_max;
+
 	/// =======================================================================
 	///  Implementation of constructors and member functions.
 	/// =======================================================================
 
-	template<typename T, typename S, std::size_t StateBits>
-	constexpr bool state_ptr<T, S, StateBits>::is_valid_state(state_type state) noexcept {
-		return static_cast<internal_type>(state) <= state_max;
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr bool state_ptr<T, S, StateBits, C>::is_valid_state(state_type state) noexcept {
+		return state_is_bounded || static_cast<internal_type>(state) <= state_max;
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	void state_ptr<T, S, StateBits>::assert_valid_state(state_type state) noexcept {
-		return assert(is_valid_state(state) && "state value is out of bounds for this state_ptr");
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr bool state_ptr<T, S, StateBits, C>::is_aligned(internal_type ptr_bits) noexcept {
+		return (ptr_bits & state_mask) == 0;
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	constexpr state_ptr<T, S, StateBits>::state_ptr(
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr void state_ptr<T, S, StateBits, C>::check(
+		internal_type ptr_bits,
+		state_type    state
+	) noexcept(check_policy_type::is_noexcept) {
+		if (check_policy_type::should_check()) {
+			if (!is_aligned(ptr_bits)) {
+				check_policy_type::fail(check_error::misaligned_pointer);
+			}
+			if (!is_valid_state(state)) {
+				check_policy_type::fail(check_error::state_out_of_bounds);
+			}
+		}
+	}
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr state_ptr<T, S, StateBits, C>::state_ptr(
 		std::nullptr_t,
 		state_type state
-	) noexcept :
-		m_ptr_and_state{0}
+	) noexcept(check_policy_type::is_noexcept) :
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		m_ptr{0},
+		m_state{static_cast<internal_type>(state)}
+#else
+		m_ptr_and_state{static_cast<internal_type>(state)}
+#endif
 	{
-		assert_valid_state(state);
-		set_state(state);
+		static_assert(StateBits <= state_bits_max(), "The alignment of T is not sufficient to store the requested amount of state bits.");
+		check(0, state);
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	state_ptr<T, S, StateBits>::state_ptr(
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	state_ptr<T, S, StateBits, C>::state_ptr(
 		pointer_type ptr,
 		state_type   state
-	) noexcept :
-		m_ptr_and_state{reinterpret_cast<internal_type>(ptr)}
+	) noexcept(check_policy_type::is_noexcept) :
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		m_ptr{reinterpret_cast<internal_type>(ptr)},
+		m_state{static_cast<internal_type>(state)}
+#else
+		m_ptr_and_state{reinterpret_cast<internal_type>(ptr) | static_cast<internal_type>(state)}
+#endif
 	{
-		assert_valid_state(state);
-		set_state(state);
+		static_assert(StateBits <= state_bits_max(), "The alignment of T is not sufficient to store the requested amount of state bits.");
+		check(reinterpret_cast<internal_type>(ptr), state);
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	constexpr auto state_ptr<T, S, StateBits>::get_ptr_bits() const noexcept -> internal_type {
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr auto state_ptr<T, S, StateBits, C>::get_ptr_bits() const noexcept -> internal_type {
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		return m_ptr & ptr_mask;
+#else
 		return m_ptr_and_state & ptr_mask;
+#endif
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	constexpr auto state_ptr<T, S, StateBits>::get_state_bits() const noexcept -> internal_type {
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr auto state_ptr<T, S, StateBits, C>::get_state_bits() const noexcept -> internal_type {
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		return m_state & state_mask;
+#else
 		return m_ptr_and_state & state_mask;
+#endif
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	void state_ptr<T, S, StateBits>::assert_invariant() const noexcept {
-		assert_valid_state(get_state());
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr auto state_ptr<T, S, StateBits, C>::raw() const noexcept -> internal_type {
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		return m_ptr | m_state;
+#else
+		return m_ptr_and_state;
+#endif
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	void state_ptr<T, S, StateBits>::set_state(state_type new_state) noexcept {
-		assert_valid_state(new_state);
-		m_ptr_and_state = get_ptr_bits() | static_cast<internal_type>(new_state);
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr auto state_ptr<T, S, StateBits, C>::from_raw(internal_type raw) noexcept -> state_ptr {
+		state_ptr result{nullptr, state_type{}};
+		result.set_bits(raw);
+		return result;
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto state_ptr<T, S, StateBits>::get_state() const noexcept -> state_type {
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr void state_ptr<T, S, StateBits, C>::set_bits(internal_type bits) noexcept {
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+		m_ptr   = bits & ptr_mask;
+		m_state = bits & state_mask;
+#else
+		m_ptr_and_state = bits;
+#endif
+	}
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr void state_ptr<T, S, StateBits, C>::set_state(state_type new_state) noexcept(check_policy_type::is_noexcept) {
+		check(get_ptr_bits(), new_state);
+		detail::notify_transition<check_policy_type, StateBits>(0, get_state_bits(), static_cast<internal_type>(new_state));
+		set_bits(get_ptr_bits() | static_cast<internal_type>(new_state));
+	}
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr auto state_ptr<T, S, StateBits, C>::get_state() const noexcept -> state_type {
 		return static_cast<state_type>(get_state_bits());
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto state_ptr<T, S, StateBits>::get_ptr() noexcept -> pointer_type {
-		return reinterpret_cast<pointer_type>(get_ptr_bits());
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	auto state_ptr<T, S, StateBits, C>::get_ptr() noexcept -> pointer_type {
+		return detail::assume_aligned<alignof(T)>(reinterpret_cast<pointer_type>(get_ptr_bits()));
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto state_ptr<T, S, StateBits>::get_ptr() const noexcept -> const_pointer_type {
-		return reinterpret_cast<const_pointer_type>(get_ptr_bits());
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	auto state_ptr<T, S, StateBits, C>::get_ptr() const noexcept -> const_pointer_type {
+		return detail::assume_aligned<alignof(T)>(reinterpret_cast<const_pointer_type>(get_ptr_bits()));
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto state_ptr<T, S, StateBits>::operator*() const noexcept -> const_reference_type {
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	auto state_ptr<T, S, StateBits, C>::operator*() const noexcept -> const_reference_type {
 		return *get_ptr();
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto state_ptr<T, S, StateBits>::operator*() noexcept -> reference_type {
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	auto state_ptr<T, S, StateBits, C>::operator*() noexcept -> reference_type {
 		return *get_ptr();
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto state_ptr<T, S, StateBits>::operator->() const noexcept -> const_pointer_type {
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	auto state_ptr<T, S, StateBits, C>::operator->() const noexcept -> const_pointer_type {
 		return get_ptr();
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto state_ptr<T, S, StateBits>::operator->() noexcept -> pointer_type {
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	void state_ptr<T, S, StateBits, C>::prefetch(prefetch_locality locality) const noexcept {
+		detail::prefetch(reinterpret_cast<void const*>(get_ptr_bits()), locality);
+	}
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	auto state_ptr<T, S, StateBits, C>::operator->() noexcept -> pointer_type {
 		return get_ptr();
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	state_ptr<T, S, StateBits>::operator bool() const noexcept {
-		return get_ptr() != nullptr;
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr state_ptr<T, S, StateBits, C>::operator bool() const noexcept {
+		return get_ptr_bits() != 0;
 	}
 
 	/// =======================================================================
 	///  Implementation of comparison operators.
 	/// =======================================================================
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto operator==(state_ptr<T, S, StateBits> const& rhs, state_ptr<T, S, StateBits> const& lhs) noexcept -> bool {
-		return lhs.m_ptr_and_state == rhs.m_ptr_and_state;
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr auto operator==(state_ptr<T, S, StateBits, C> const& lhs, state_ptr<T, S, StateBits, C> const& rhs) noexcept -> bool {
+		return lhs.raw() == rhs.raw();
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto operator!=(state_ptr<T, S, StateBits> const& rhs, state_ptr<T, S, StateBits> const& lhs) noexcept -> bool {
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr auto operator!=(state_ptr<T, S, StateBits, C> const& lhs, state_ptr<T, S, StateBits, C> const& rhs) noexcept -> bool {
 		return !(lhs == rhs);
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	bool operator==(state_ptr<T, S, StateBits> const& rhs, std::nullptr_t) noexcept {
-		return rhs.get_ptr() == nullptr;
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr bool operator==(state_ptr<T, S, StateBits, C> const& lhs, std::nullptr_t) noexcept {
+		return lhs.get_ptr_bits() == 0;
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	bool operator!=(state_ptr<T, S, StateBits> const& rhs, std::nullptr_t) noexcept {
-		return rhs.get_ptr() != nullptr;
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr bool operator!=(state_ptr<T, S, StateBits, C> const& lhs, std::nullptr_t) noexcept {
+		return !(lhs == nullptr);
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	bool operator==(std::nullptr_t, state_ptr<T, S, StateBits> const& lhs) noexcept {
-		return nullptr == lhs;
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr bool operator==(std::nullptr_t, state_ptr<T, S, StateBits, C> const& rhs) noexcept {
+		return rhs == nullptr;
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	bool operator!=(std::nullptr_t, state_ptr<T, S, StateBits> const& lhs) noexcept {
-		return nullptr == lhs;
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr bool operator!=(std::nullptr_t, state_ptr<T, S, StateBits, C> const& rhs) noexcept {
+		return !(rhs == nullptr);
 	}
 
 	/// =======================================================================
 	///  Implementation of relational operators.
+	///
+	///  state_ptr are ordered by their full word which orders them by address
+	///  first and by state second. This is a total order that is consistent
+	///  with equality and as cheap as comparing two integers. Use
+	///  state_ptr_address_less to order by the address only.
 	/// =======================================================================
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto operator<(state_ptr<T, S, StateBits> const& rhs, state_ptr<T> const& lhs) noexcept -> bool {
-		return !(lhs.m_ptr < rhs.m_ptr);
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr auto operator<(state_ptr<T, S, StateBits, C> const& lhs, state_ptr<T, S, StateBits, C> const& rhs) noexcept -> bool {
+		return lhs.raw() < rhs.raw();
+	}
+
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr auto operator<=(state_ptr<T, S, StateBits, C> const& lhs, state_ptr<T, S, StateBits, C> const& rhs) noexcept -> bool {
+		return !(rhs < lhs);
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto operator<=(state_ptr<T, S, StateBits> const& rhs, state_ptr<T> const& lhs) noexcept -> bool {
-		return !(lhs > rhs);
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr auto operator>(state_ptr<T, S, StateBits, C> const& lhs, state_ptr<T, S, StateBits, C> const& rhs) noexcept -> bool {
+		return rhs < lhs;
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto operator>=(state_ptr<T, S, StateBits> const& rhs, state_ptr<T> const& lhs) noexcept -> bool {
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr auto operator>=(state_ptr<T, S, StateBits, C> const& lhs, state_ptr<T, S, StateBits, C> const& rhs) noexcept -> bool {
 		return !(lhs < rhs);
 	}
 
-	template<typename T, typename S, std::size_t StateBits>
-	auto operator>(state_ptr<T, S, StateBits> const& rhs, state_ptr<T> const& lhs) noexcept -> bool {
-		return !(lhs <= rhs);
+#if UTILS_STATE_PTR_HAS_THREE_WAY_COMPARISON
+	template<typename T, typename S, std::size_t StateBits, typename C>
+	constexpr auto operator<=>(state_ptr<T, S, StateBits, C> const& lhs, state_ptr<T, S, StateBits, C> const& rhs) noexcept -> std::strong_ordering {
+		return lhs.raw() <=> rhs.raw();
 	}
+#endif
+
+	/// \brief Orders state_ptr by their address only, ignoring their states.
+	///
+	/// This is a strict weak ordering: state_ptr with equal addresses but
+	/// different states are equivalent. Use this to key ordered containers by
+	/// the pointee, e.g. `std::set<state_ptr<T>, state_ptr_address_less>`.
+	struct state_ptr_address_less {
+		template<typename T, typename S, std::size_t StateBits, typename C>
+		auto operator()(state_ptr<T, S, StateBits, C> const& lhs, state_ptr<T, S, StateBits, C> const& rhs) const noexcept -> bool {
+			return std::less<typename state_ptr<T, S, StateBits, C>::const_pointer_type>()(lhs.get_ptr(), rhs.get_ptr());
+		}
+	};
 }
 
 /// ===========================================================================
@@ -357,12 +898,12 @@ namespace UTILS_STATE_PTR_HPP_NAMESPACE {
 /// ===========================================================================
 
 namespace std {
-	template<typename T, typename S, size_t StateBits>
-	struct hash<putl::state_ptr<T, S, StateBits>> {
+	template<typename T, typename S, size_t StateBits, typename C>
+	struct hash<UTILS_STATE_PTR_HPP_NAMESPACE::state_ptr<T, S, StateBits, C>> {
 	public:
-		size_t operator()(const putl::state_ptr<T, S> &p) const 
-		{
-			return std::hash<typename putl::state_ptr<T, S>::internal_type>()(p.m_ptr_and_state);
+		constexpr size_t operator()(UTILS_STATE_PTR_HPP_NAMESPACE::state_ptr<T, S, StateBits, C> const& p) const noexcept {
+			// Same as std::hash<std::uintptr_t> of common standard libraries but usable in constant expressions.
+			return static_cast<size_t>(p.raw());
 		}
 	};
 }
@@ -0,0 +1,134 @@
+#ifndef POINTER_UTILS_STATE_PTR_FORMAT_HPP
+#define POINTER_UTILS_STATE_PTR_FORMAT_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+#if defined(__has_include)
+#if __cplusplus >= 202002L && __has_include(<format>)
+#include <format>
+#endif
+#endif
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	/// \brief Returns a human-readable description of the given state_ptr,
+	///        e.g. `state_ptr(0x7ffd5a3c1230, 2)`.
+	///
+	/// The state is printed as its integer value.
+	template<typename T, typename S, std::size_t B, typename C>
+	auto to_string(state_ptr<T, S, B, C> const& p) -> std::string;
+
+	/// \brief Returns the internal representation of the given state_ptr as
+	///        binary digits with the pointer and the state bits separated by `|`.
+	///
+	/// This is meant for debugging the bit layout, e.g. `0...0101000|10`.
+	template<typename T, typename S, std::size_t B, typename C>
+	auto to_bit_string(state_ptr<T, S, B, C> const& p) -> std::string;
+
+	/// \brief Writes the description returned by to_string to the given stream.
+	template<typename T, typename S, std::size_t B, typename C>
+	auto operator<<(std::ostream& os, state_ptr<T, S, B, C> const& p) -> std::ostream&;
+
+	/// =======================================================================
+	///  Implementation of the formatting functions.
+	/// =======================================================================
+
+	template<typename T, typename S, std::size_t B, typename C>
+	auto to_string(state_ptr<T, S, B, C> const& p) -> std::string {
+		using layout = typename state_ptr<T, S, B, C>::layout;
+		auto const raw   = p.raw();
+		auto       ptr   = raw & layout::ptr_mask;
+		auto const state = (raw & layout::state_mask) >> layout::state_shift;
+		std::string hex;
+		do {
+			hex.push_back("0123456789abcdef"[ptr & 0xfu]);
+			ptr >>= 4;
+		} while (ptr != 0);
+		std::reverse(hex.begin(), hex.end());
+		return "state_ptr(0x" + hex + ", " + std::to_string(state) + ")";
+	}
+
+	template<typename T, typename S, std::size_t B, typename C>
+	auto to_bit_string(state_ptr<T, S, B, C> const& p) -> std::string {
+		using layout = typename state_ptr<T, S, B, C>::layout;
+		auto const raw = p.raw();
+		std::string bits;
+		bits.reserve(layout::word_bits + 1);
+		for (std::size_t i = layout::word_bits; i-- > 0;) {
+			bits.push_back(((raw >> i) & 1u) != 0 ? '1' : '0');
+			if (i == layout::ptr_shift && layout::state_bits != 0) {
+				bits.push_back('|');
+			}
+		}
+		return bits;
+	}
+
+	template<typename T, typename S, std::size_t B, typename C>
+	auto operator<<(std::ostream& os, state_ptr<T, S, B, C> const& p) -> std::ostream& {
+		return os << to_string(p);
+	}
+}
+
+/// ===========================================================================
+///  Formatter specializations for std::format and fmt.
+///
+///  The empty format spec prints to_string, the `b` spec prints to_bit_string.
+///  The fmt formatter is provided if fmt is included before this header.
+/// ===========================================================================
+
+#if defined(__cpp_lib_format) && __cpp_lib_format >= 201907L
+template<typename T, typename S, std::size_t B, typename C>
+struct std::formatter<UTILS_STATE_PTR_HPP_NAMESPACE::state_ptr<T, S, B, C>, char> {
+	bool m_bits = false;
+
+	constexpr auto parse(std::format_parse_context& ctx) -> std::format_parse_context::iterator {
+		auto it = ctx.begin();
+		if (it != ctx.end() && *it == 'b') {
+			m_bits = true;
+			++it;
+		}
+		if (it != ctx.end() && *it != '}') {
+			throw std::format_error{"invalid format spec for state_ptr"};
+		}
+		return it;
+	}
+
+	template<typename FormatContext>
+	auto format(UTILS_STATE_PTR_HPP_NAMESPACE::state_ptr<T, S, B, C> const& p, FormatContext& ctx) const -> decltype(ctx.out()) {
+		auto const s = m_bits ? UTILS_STATE_PTR_HPP_NAMESPACE::to_bit_string(p) : UTILS_STATE_PTR_HPP_NAMESPACE::to_string(p);
+		return std::copy(s.begin(), s.end(), ctx.out());
+	}
+};
+#endif
+
+#if defined(FMT_VERSION)
+template<typename T, typename S, std::size_t B, typename C>
+struct fmt::formatter<UTILS_STATE_PTR_HPP_NAMESPACE::state_ptr<T, S, B, C>, char> {
+	bool m_bits = false;
+
+	template<typename ParseContext>
+	constexpr auto parse(ParseContext& ctx) -> decltype(ctx.begin()) {
+		auto it = ctx.begin();
+		if (it != ctx.end() && *it == 'b') {
+			m_bits = true;
+			++it;
+		}
+		if (it != ctx.end() && *it != '}') {
+			throw fmt::format_error{"invalid format spec for state_ptr"};
+		}
+		return it;
+	}
+
+	template<typename FormatContext>
+	auto format(UTILS_STATE_PTR_HPP_NAMESPACE::state_ptr<T, S, B, C> const& p, FormatContext& ctx) const -> decltype(ctx.out()) {
+		auto const s = m_bits ? UTILS_STATE_PTR_HPP_NAMESPACE::to_bit_string(p) : UTILS_STATE_PTR_HPP_NAMESPACE::to_string(p);
+		return std::copy(s.begin(), s.end(), ctx.out());
+	}
+};
+#endif
+
+#endif // POINTER_UTILS_STATE_PTR_FORMAT_HPP
@@ -0,0 +1,222 @@
+#ifndef POINTER_UTILS_TRANSITION_TELEMETRY_HPP
+#define POINTER_UTILS_TRANSITION_TELEMETRY_HPP
+
+#include <putl/state_ptr.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace UTILS_STATE_PTR_HPP_NAMESPACE {
+	/// \brief A square matrix of state transition counts indexed by (old, new) state.
+	class transition_matrix {
+	public:
+		/// \brief Creates a matrix for the given number of states with all counts zero.
+		explicit transition_matrix(std::size_t states);
+
+		/// \brief Returns the number of states.
+		auto states() const noexcept -> std::size_t;
+
+		/// \brief Returns the number of transitions from state `from` to state `to`.
+		auto count(std::size_t from, std::size_t to) const noexcept -> std::uint64_t;
+
+		/// \brief Adds the given number of transitions from state `from` to state `to`.
+		void add(std::size_t from, std::size_t to, std::uint64_t count) noexcept;
+
+		/// \brief Returns the number of all transitions.
+		auto total() const noexcept -> std::uint64_t;
+
+	private:
+		std::size_t                m_states;
+		std::vector<std::uint64_t> m_counts;
+	};
+
+	/// \brief Records state transitions in per-thread, cache-line padded counters.
+	///
+	/// Every thread increments its own counters without synchronization with
+	/// other threads, snapshot aggregates the counters of all threads into a
+	/// transition_matrix on demand. Counters of exited threads are retained.
+	///
+	/// With a `SamplingPeriod` greater than `1` only every `SamplingPeriod`-th
+	/// transition per thread is recorded and weighted accordingly, which bounds
+	/// the overhead to a thread-local countdown for most transitions.
+	///
+	/// Distinct `Tag` types yield independent sets of counters, e.g. one per
+	/// state machine.
+	template<std::size_t StateBits, typename Tag = void, std::uint32_t SamplingPeriod = 1>
+	class transition_telemetry {
+	public:
+		static_assert(StateBits <= 4, "transition_telemetry supports at most 4 state bits.");
+		static_assert(SamplingPeriod > 0, "The sampling period must be positive.");
+
+		/// \brief The number of state bits of the recorded states.
+		constexpr static std::size_t state_bits = StateBits;
+
+		/// \brief The number of distinct states.
+		constexpr static std::size_t states = std::size_t{1} << StateBits;
+
+		/// \brief Records a transition from state `from` to state `to`.
+		///
+		/// The first transition recorded by a thread registers its counters
+		/// which allocates and may throw std::bad_alloc.
+		static void record(std::uintptr_t from, std::uintptr_t to);
+
+		/// \brief Returns the transitions recorded by all threads so far.
+		///
+		/// Concurrently recorded transitions may or may not be included.
+		static auto snapshot() -> transition_matrix;
+
+		/// \brief Resets the counters of all threads to zero.
+		///
+		/// Concurrently recorded transitions may be lost.
+		static void reset();
+
+	private:
+		/// \brief Number of bytes used to separate the counters of different threads.
+		constexpr static std::size_t cache_line = 64;
+
+		/// \brief The counters of a single thread.
+		///
+		/// Counters are padded on both sides to avoid false sharing with the
+		/// counters of other threads without requiring over-aligned allocation.
+		struct thread_counters {
+			char                       m_front_padding[cache_line];
+			std::atomic<std::uint64_t> m_counts[states * states];
+			char                       m_back_padding[cache_line];
+		};
+
+		/// \brief The counters of all threads that recorded transitions.
+		struct registry {
+			std::mutex                                    m_mutex;
+			std::vector<std::unique_ptr<thread_counters>> m_threads;
+		};
+
+		static auto get_registry() -> registry&;
+
+		/// \brief Returns the counters of the calling thread, registering them on first use.
+		static auto local_counters() -> thread_counters&;
+	};
+
+	namespace check_policy {
+		/// \brief Validates input like `Base` and records all state transitions
+		///        of `set_state` with the `Telemetry` recorder, e.g. transition_telemetry.
+		///
+		/// The recorder must provide `state_bits`, the number of state bits it
+		/// records, which must not be less than those of the instrumented state_ptr.
+		///
+		/// Since recording may allocate, `set_state` of an instrumented state_ptr
+		/// is not noexcept.
+		template<typename Telemetry, typename Base = assertion>
+		struct instrumented : Base {
+			constexpr static bool is_noexcept = false;
+
+			template<std::size_t StateBits>
+			static void on_transition(std::uintptr_t from, std::uintptr_t to) {
+				static_assert(StateBits <= Telemetry::state_bits,
+					"The telemetry records fewer state bits than the instrumented state_ptr has.");
+				Telemetry::record(from, to);
+			}
+		};
+	}
+
+	/// =======================================================================
+	///  Implementation of transition_matrix.
+	/// =======================================================================
+
+	inline transition_matrix::transition_matrix(std::size_t states) :
+		m_states{states},
+		m_counts(states * states, 0)
+	{}
+
+	inline auto transition_matrix::states() const noexcept -> std::size_t {
+		return m_states;
+	}
+
+	inline auto transition_matrix::count(std::size_t from, std::size_t to) const noexcept -> std::uint64_t {
+		assert(from < m_states && to < m_states && "state is out of bounds for this transition_matrix");
+		return m_counts[from * m_states + to];
+	}
+
+	inline void transition_matrix::add(std::size_t from, std::size_t to, std::uint64_t count) noexcept {
+		assert(from < m_states && to < m_states && "state is out of bounds for this transition_matrix");
+		m_counts[from * m_states + to] += count;
+	}
+
+	inline auto transition_matrix::total() const noexcept -> std::uint64_t {
+		std::uint64_t sum = 0;
+		for (auto const count : m_counts) {
+			sum += count;
+		}
+		return sum;
+	}
+
+	/// =======================================================================
+	///  Implementation of transition_telemetry.
+	/// =======================================================================
+
+	template<std::size_t B, typename Tag, std::uint32_t N>
+	auto transition_telemetry<B, Tag, N>::get_registry() -> registry& {
+		static registry instance;
+		return instance;
+	}
+
+	template<std::size_t B, typename Tag, std::uint32_t N>
+	auto transition_telemetry<B, Tag, N>::local_counters() -> thread_counters& {
+		static thread_local thread_counters* local = [] {
+			std::unique_ptr<thread_counters> counters{new thread_counters{}};
+			auto& r = get_registry();
+			std::lock_guard<std::mutex> lock{r.m_mutex};
+			r.m_threads.push_back(std::move(counters));
+			return r.m_threads.back().get();
+		}();
+		return *local;
+	}
+
+	template<std::size_t B, typename Tag, std::uint32_t N>
+	void transition_telemetry<B, Tag, N>::record(std::uintptr_t from, std::uintptr_t to) {
+		assert(from < states && to < states && "state is out of bounds for this transition_telemetry");
+		if (N > 1) {
+			static thread_local std::uint32_t countdown = 0;
+			if (countdown != 0) {
+				--countdown;
+				return;
+			}
+			countdown = N - 1;
+		}
+		// Only the owning thread writes its counters, so a relaxed load and
+		// store suffice and avoid a locked read-modify-write.
+		auto& counter = local_counters().m_counts[from * states + to];
+		counter.store(counter.load(std::memory_order_relaxed) + N, std::memory_order_relaxed);
+	}
+
+	template<std::size_t B, typename Tag, std::uint32_t N>
+	auto transition_telemetry<B, Tag, N>::snapshot() -> transition_matrix {
+		transition_matrix matrix{states};
+		auto& r = get_registry();
+		std::lock_guard<std::mutex> lock{r.m_mutex};
+		for (auto const& counters : r.m_threads) {
+			for (std::size_t from = 0; from < states; ++from) {
+				for (std::size_t to = 0; to < states; ++to) {
+					matrix.add(from, to, counters->m_counts[from * states + to].load(std::memory_order_relaxed));
+				}
+			}
+		}
+		return matrix;
+	}
+
+	template<std::size_t B, typename Tag, std::uint32_t N>
+	void transition_telemetry<B, Tag, N>::reset() {
+		auto& r = get_registry();
+		std::lock_guard<std::mutex> lock{r.m_mutex};
+		for (auto const& counters : r.m_threads) {
+			for (auto& count : counters->m_counts) {
+				count.store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+}
+
+#endif // POINTER_UTILS_TRANSITION_TELEMETRY_HPP
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <putl/batch_lookup.hpp>
+#include <putl/state_ptr.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace putl;
+
+struct alignas(8) ChainNode {
+	std::uint64_t                           key;
+	state_ptr<ChainNode, std::uintptr_t, 1> next;
+};
+
+struct alignas(8) TreeNode {
+	std::uint64_t                          key;
+	state_ptr<TreeNode, std::uintptr_t, 1> left;
+	state_ptr<TreeNode, std::uintptr_t, 1> right;
+};
+
+using chain_ptr = state_ptr<ChainNode, std::uintptr_t, 1>;
+using tree_ptr  = state_ptr<TreeNode, std::uintptr_t, 1>;
+
+/// \brief A chained hash table with the given number of buckets.
+struct HashTable {
+	explicit HashTable(std::vector<std::uint64_t> const& keys, std::size_t buckets) :
+		nodes(keys.size(), ChainNode{0, {nullptr, 0}}),
+		heads(buckets, chain_ptr{nullptr, 0})
+	{
+		for (std::size_t i = 0; i < keys.size(); ++i) {
+			auto& head = heads[keys[i] % buckets];
+			nodes[i]   = ChainNode{keys[i], head};
+			head       = {&nodes[i], keys[i] % 2};
+		}
+	}
+
+	std::vector<ChainNode> nodes;
+	std::vector<chain_ptr> heads;
+};
+
+auto build_tree(std::vector<std::uint64_t> const& keys) -> std::vector<TreeNode> {
+	std::vector<TreeNode> nodes(keys.size(), TreeNode{0, {nullptr, 0}, {nullptr, 0}});
+	for (std::size_t i = 0; i < keys.size(); ++i) {
+		nodes[i].key = keys[i];
+		if (i == 0) {
+			continue;
+		}
+		for (auto parent = &nodes[0];;) {
+			auto& link = keys[i] < parent->key ? parent->left : parent->right;
+			if (!link) {
+				link = {&nodes[i], 1};
+				break;
+			}
+			parent = link.get_ptr();
+		}
+	}
+	return nodes;
+}
+
+auto random_keys(std::size_t count, std::uint64_t seed) -> std::vector<std::uint64_t> {
+	std::mt19937_64 rng{seed};
+	std::vector<std::uint64_t> keys(count);
+	for (auto& key : keys) {
+		key = rng() % 1000000;
+	}
+	return keys;
+}
+
+auto step_chain(std::uint64_t key, chain_ptr p) -> batch_step<chain_ptr> {
+	return p->key == key ? batch_step<chain_ptr>::finish(p) : batch_step<chain_ptr>::follow(p->next);
+}
+
+auto step_tree(std::uint64_t key, tree_ptr p) -> batch_step<tree_ptr> {
+	if (p->key == key) {
+		return batch_step<tree_ptr>::finish(p);
+	}
+	return batch_step<tree_ptr>::follow(key < p->key ? p->left : p->right);
+}
+
+template<std::size_t Width>
+void expect_chain_lookups(HashTable const& table, std::vector<std::uint64_t> const& queries) {
+	std::vector<chain_ptr> results(queries.size(), chain_ptr{nullptr, 0});
+	batch_lookup<Width>(queries.begin(), queries.end(), results.begin(),
+		[&](std::uint64_t key) { return table.heads[key % table.heads.size()]; },
+		step_chain);
+	for (std::size_t i = 0; i < queries.size(); ++i) {
+		auto expected = table.heads[queries[i] % table.heads.size()];
+		while (expected && expected->key != queries[i]) {
+			expected = expected->next;
+		}
+		EXPECT_EQ(results[i], expected) << "width " << Width << ", query " << i;
+	}
+}
+
+template<std::size_t Width>
+void expect_tree_lookups(std::vector<TreeNode> const& tree, std::vector<std::uint64_t> const& queries) {
+	tree_ptr const root{const_cast<TreeNode*>(tree.data()), 0};
+	std::vector<tree_ptr> results(queries.size(), tree_ptr{nullptr, 0});
+	batch_lookup<Width>(queries.begin(), queries.end(), results.begin(),
+		[&](std::uint64_t) { return root; },
+		step_tree);
+	for (std::size_t i = 0; i < queries.size(); ++i) {
+		auto expected = root;
+		while (expected && expected->key != queries[i]) {
+			expected = queries[i] < expected->key ? expected->left : expected->right;
+		}
+		EXPECT_EQ(results[i], expected) << "width " << Width << ", query " << i;
+	}
+}
+
+TEST(BatchLookup, HashChains) {
+	auto const keys = random_keys(1000, 1);
+	HashTable const table{keys, 97};
+	auto queries = random_keys(500, 2);
+	queries.insert(queries.end(), keys.begin(), keys.begin() + 500);
+	expect_chain_lookups<1>(table, queries);
+	expect_chain_lookups<3>(table, queries);
+	expect_chain_lookups<16>(table, queries);
+	expect_chain_lookups<64>(table, queries);
+}
+
+TEST(BatchLookup, EmptyBucketsFinishImmediately) {
+	auto const keys = random_keys(10, 3);
+	HashTable const table{keys, 1024};
+	auto queries = random_keys(200, 4);
+	queries.insert(queries.end(), keys.begin(), keys.end());
+	expect_chain_lookups<4>(table, queries);
+	expect_chain_lookups<8>(table, queries);
+}
+
+TEST(BatchLookup, Trees) {
+	auto const keys = random_keys(1000, 5);
+	auto const tree = build_tree(keys);
+	auto queries = random_keys(500, 6);
+	queries.insert(queries.end(), keys.rbegin(), keys.rbegin() + 500);
+	expect_tree_lookups<1>(tree, queries);
+	expect_tree_lookups<2>(tree, queries);
+	expect_tree_lookups<7>(tree, queries);
+	expect_tree_lookups<64>(tree, queries);
+}
+
+TEST(BatchLookup, FewerKeysThanWidth) {
+	auto const keys = random_keys(100, 7);
+	auto const tree = build_tree(keys);
+	std::vector<std::uint64_t> const queries = {keys[3], keys[42], 1000001};
+	expect_tree_lookups<64>(tree, queries);
+}
+
+TEST(BatchLookup, NoKeys) {
+	std::vector<std::uint64_t> const queries;
+	std::vector<tree_ptr> results;
+	auto starts = 0;
+	batch_lookup<8>(queries.begin(), queries.end(), results.begin(),
+		[&](std::uint64_t) { ++starts; return tree_ptr{nullptr, 0}; },
+		step_tree);
+	EXPECT_EQ(starts, 0);
+}
+
+} // namespace
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <putl/clock_cache.hpp>
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace putl;
+
+TEST(AtomicStatePointer, LoadStore) {
+	int foo{42};
+	atomic_state_ptr<int> p{};
+	EXPECT_EQ(p.load(), nullptr);
+	p.store(state_ptr<int>{&foo, 3});
+	EXPECT_EQ(p.get_ptr(), &foo);
+	EXPECT_EQ(p.get_state(), 3ul);
+}
+
+TEST(AtomicStatePointer, FetchOrAndState) {
+	int foo{42};
+	atomic_state_ptr<int> p{state_ptr<int>{&foo, 0}};
+	EXPECT_EQ(p.fetch_or_state(1), 0ul);
+	EXPECT_EQ(p.fetch_or_state(2), 1ul);
+	EXPECT_EQ(p.get_state(), 3ul);
+	EXPECT_EQ(p.fetch_and_state(2), 3ul);
+	EXPECT_EQ(p.get_state(), 2ul);
+	EXPECT_EQ(p.get_ptr(), &foo);
+}
+
+TEST(AtomicStatePointer, CompareExchange) {
+	int foo{42};
+	int bar{1337};
+	atomic_state_ptr<int> p{state_ptr<int>{&foo, 1}};
+	state_ptr<int> expected{&foo, 0};
+	EXPECT_FALSE(p.compare_exchange_strong(expected, state_ptr<int>{&bar, 2}));
+	EXPECT_EQ(expected, (state_ptr<int>{&foo, 1}));
+	EXPECT_TRUE(p.compare_exchange_strong(expected, state_ptr<int>{&bar, 2}));
+	EXPECT_EQ(p.load(), (state_ptr<int>{&bar, 2}));
+}
+
+TEST(ClockCache, InsertFind) {
+	clock_cache<int, std::string> cache{4};
+	EXPECT_EQ(cache.find(1), nullptr);
+	cache.insert(1, "one");
+	cache.insert(2, "two");
+	ASSERT_NE(cache.find(1), nullptr);
+	EXPECT_EQ(*cache.find(1), "one");
+	EXPECT_EQ(*cache.find(2), "two");
+	EXPECT_EQ(cache.size(), 2u);
+}
+
+TEST(ClockCache, InsertReplaces) {
+	clock_cache<int, std::string> cache{2};
+	cache.insert(1, "one");
+	cache.insert(1, "uno");
+	EXPECT_EQ(*cache.find(1), "uno");
+	EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(ClockCache, EvictsUnreferenced) {
+	clock_cache<int, int> cache{3};
+	cache.insert(1, 10);
+	cache.insert(2, 20);
+	cache.insert(3, 30);
+	EXPECT_NE(cache.find(1), nullptr);
+	EXPECT_NE(cache.find(3), nullptr);
+	cache.insert(4, 40);
+	EXPECT_EQ(cache.size(), 3u);
+	EXPECT_EQ(cache.find(2), nullptr);
+	EXPECT_NE(cache.find(1), nullptr);
+	EXPECT_NE(cache.find(3), nullptr);
+	EXPECT_NE(cache.find(4), nullptr);
+}
+
+TEST(ClockCache, SecondChance) {
+	clock_cache<int, int> cache{2};
+	cache.insert(1, 10);
+	cache.insert(2, 20);
+	cache.find(1);
+	cache.find(2);
+	// Both are referenced: the hand clears both bits and evicts the first.
+	cache.insert(3, 30);
+	EXPECT_EQ(cache.find(1), nullptr);
+	EXPECT_NE(cache.find(2), nullptr);
+	EXPECT_NE(cache.find(3), nullptr);
+}
+
+TEST(ClockCache, Erase) {
+	clock_cache<int, int> cache{2};
+	cache.insert(1, 10);
+	EXPECT_TRUE(cache.erase(1));
+	EXPECT_FALSE(cache.erase(1));
+	EXPECT_EQ(cache.find(1), nullptr);
+	EXPECT_EQ(cache.size(), 0u);
+}
+
+/// \brief Hashes like std::hash but throws on the hashing with the given index.
+struct ThrowingHash {
+	static int calls_until_throw;
+
+	auto operator()(int key) const -> std::size_t {
+		if (calls_until_throw-- == 0) {
+			throw std::runtime_error{"hash failed"};
+		}
+		return std::hash<int>{}(key);
+	}
+};
+
+int ThrowingHash::calls_until_throw = -1;
+
+TEST(ClockCache, InsertIsExceptionSafe) {
+	clock_cache<int, std::string, ThrowingHash> cache{2};
+	cache.insert(1, "one");
+	// The lookup of the key succeeds, the insertion into the index throws.
+	ThrowingHash::calls_until_throw = 1;
+	EXPECT_THROW(cache.insert(2, "two"), std::runtime_error);
+	ThrowingHash::calls_until_throw = -1;
+	EXPECT_EQ(cache.size(), 1u);
+	EXPECT_EQ(cache.find(2), nullptr);
+	cache.insert(2, "two");
+	EXPECT_EQ(*cache.find(2), "two");
+}
+
+TEST(ClockCache, RejectsZeroCapacity) {
+	EXPECT_THROW((clock_cache<int, int>{0}), std::invalid_argument);
+	EXPECT_THROW((concurrent_clock_cache<int, int>{0, 1}), std::invalid_argument);
+	EXPECT_THROW((concurrent_clock_cache<int, int>{4, 0}), std::invalid_argument);
+	EXPECT_THROW((concurrent_clock_cache<int, int>{2, 4}), std::invalid_argument);
+}
+
+TEST(ConcurrentClockCache, ParallelAccess) {
+	concurrent_clock_cache<int, int> cache{64, 4};
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&cache, t] {
+			for (int i = 0; i < 1000; ++i) {
+				auto const key = (i * 7 + t) % 128;
+				int value = 0;
+				if (cache.find(key, value)) {
+					EXPECT_EQ(value, key * 2);
+				}
+				else {
+					cache.insert(key, key * 2);
+				}
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	EXPECT_LE(cache.size(), 64u);
+}
+
+} // namespace
@@ -0,0 +1,112 @@
+# Checks the assembly in ASM_FILE against the expectations in PROBE_SOURCE.
+#
+# Expectations are comments of the form
+#
+#     // CODEGEN: <function> MAX_INSTRUCTIONS <n>
+#     // CODEGEN: <function> CONTAINS <regex>
+#     // CODEGEN: <function> NOT_CONTAINS <regex>
+#     // CODEGEN: <function> COUNT <n> <regex>
+#     // CODEGEN: <function> NOT_LONGER_THAN <other function>
+#
+# where <function> is the unmangled name of an `extern "C"` probe function and
+# <regex> is a CMake regular expression matched against single instructions,
+# e.g. `andq $-16, %rax`. Whitespace within instructions is collapsed to single
+# spaces. Labels and assembler directives are not instructions.
+
+if(NOT PROBE_SOURCE OR NOT ASM_FILE)
+	message(FATAL_ERROR "Usage: cmake -DPROBE_SOURCE=<file> -DASM_FILE=<file> -P check_asm.cmake")
+endif()
+
+file(STRINGS ${ASM_FILE} asm_lines)
+file(STRINGS ${PROBE_SOURCE} expectations REGEX "^// CODEGEN: ")
+
+# Returns the instructions of the given function in `out_var`.
+function(get_instructions function out_var)
+	set(inside FALSE)
+	set(found FALSE)
+	set(result "")
+	foreach(line IN LISTS asm_lines)
+		if(line MATCHES "^${function}:")
+			set(inside TRUE)
+			set(found TRUE)
+		elseif(inside AND line MATCHES "^[ \t]*\\.size[ \t]+${function},")
+			set(inside FALSE)
+		elseif(inside AND line MATCHES "^[ \t]+[a-z]")
+			string(STRIP "${line}" instruction)
+			string(REGEX REPLACE "[ \t]+" " " instruction "${instruction}")
+			# Semicolons would split the instruction into list elements.
+			string(REPLACE ";" "," instruction "${instruction}")
+			list(APPEND result "${instruction}")
+		endif()
+	endforeach()
+	if(NOT found)
+		message(SEND_ERROR "${function}: function not found in ${ASM_FILE}")
+	endif()
+	set(${out_var} "${result}" PARENT_SCOPE)
+endfunction()
+
+# Returns the number of the given instructions that match the given regex in `out_var`.
+function(count_matches instructions regex out_var)
+	set(count 0)
+	foreach(instruction IN LISTS instructions)
+		if(instruction MATCHES "${regex}")
+			math(EXPR count "${count} + 1")
+		endif()
+	endforeach()
+	set(${out_var} ${count} PARENT_SCOPE)
+endfunction()
+
+set(failures 0)
+foreach(expectation IN LISTS expectations)
+	string(REGEX REPLACE "^// CODEGEN: " "" expectation "${expectation}")
+	string(REGEX MATCH "^([A-Za-z0-9_]+) +([A-Z_]+) +(.*)$" _ "${expectation}")
+	set(function ${CMAKE_MATCH_1})
+	set(kind ${CMAKE_MATCH_2})
+	set(args "${CMAKE_MATCH_3}")
+	get_instructions(${function} instructions)
+	list(LENGTH instructions instruction_count)
+	string(REPLACE ";" "\n\t" listing "${instructions}")
+
+	set(ok TRUE)
+	if(kind STREQUAL "MAX_INSTRUCTIONS")
+		if(instruction_count GREATER args)
+			set(ok FALSE)
+		endif()
+	elseif(kind STREQUAL "NOT_LONGER_THAN")
+		get_instructions(${args} other_instructions)
+		list(LENGTH other_instructions other_count)
+		if(instruction_count GREATER other_count)
+			set(ok FALSE)
+		endif()
+	elseif(kind STREQUAL "CONTAINS")
+		count_matches("${instructions}" "${args}" matches)
+		if(matches EQUAL 0)
+			set(ok FALSE)
+		endif()
+	elseif(kind STREQUAL "NOT_CONTAINS")
+		count_matches("${instructions}" "${args}" matches)
+		if(NOT matches EQUAL 0)
+			set(ok FALSE)
+		endif()
+	elseif(kind STREQUAL "COUNT")
+		string(REGEX MATCH "^([0-9]+) +(.*)$" _ "${args}")
+		set(expected ${CMAKE_MATCH_1})
+		count_matches("${instructions}" "${CMAKE_MATCH_2}" matches)
+		if(NOT matches EQUAL expected)
+			set(ok FALSE)
+		endif()
+	else()
+		message(FATAL_ERROR "Unknown codegen expectation: ${expectation}")
+	endif()
+
+	if(ok)
+		message(STATUS "PASS: ${expectation}")
+	else()
+		message(SEND_ERROR "FAIL: ${expectation}\nInstructions of ${function}:\n\t${listing}")
+		math(EXPR failures "${failures} + 1")
+	endif()
+endforeach()
+
+if(failures GREATER 0)
+	message(FATAL_ERROR "${failures} codegen expectation(s) failed for ${PROBE_SOURCE}")
+endif()
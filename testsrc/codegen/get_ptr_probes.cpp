@@ -0,0 +1,32 @@
+// Codegen probes for state_ptr::get_ptr. See check_asm.cmake for the format of
+// the expectations below.
+
+#include <putl/state_ptr.hpp>
+
+#include <cstdint>
+
+using namespace putl;
+
+struct alignas(16) Block {
+	std::int32_t data[64];
+};
+
+// Masking off the state is a single AND.
+// CODEGEN: probe_get_ptr MAX_INSTRUCTIONS 3
+// CODEGEN: probe_get_ptr COUNT 1 ^and
+// CODEGEN: probe_get_ptr NOT_CONTAINS ^call
+extern "C" auto probe_get_ptr(state_ptr<Block> p) -> Block* {
+	return p.get_ptr();
+}
+
+// With only one state bit the mask alone would prove 2-byte alignment. The
+// alignment assumption of get_ptr must still yield aligned vector accesses.
+// CODEGEN: probe_scale_few_state_bits CONTAINS ^movdqa
+// CODEGEN: probe_scale_few_state_bits NOT_CONTAINS ^movdqu
+// CODEGEN: probe_scale_few_state_bits NOT_CONTAINS ^movups
+extern "C" void probe_scale_few_state_bits(state_ptr<Block, std::uintptr_t, 1> p) {
+	auto const data = reinterpret_cast<std::int32_t*>(p.get_ptr());
+	for (int i = 0; i < 64; ++i) {
+		data[i] *= 3;
+	}
+}
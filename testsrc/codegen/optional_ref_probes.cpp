@@ -0,0 +1,62 @@
+// Codegen probes for optional_ref. See check_asm.cmake for the format of the
+// expectations below.
+//
+// optional_ref shall cost the same as a raw pointer that may be null: it is
+// returned in a single register and checking and unwrapping it adds no
+// instructions beyond the comparison a null check would need. It must never
+// be worse than std::optional<T*>, which these probes are compiled against as
+// C++17.
+
+#include <putl/optional_ref.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+using namespace putl;
+
+struct Entry {
+	std::uint64_t key;
+	std::uint64_t value;
+};
+
+// The raw pointer baseline of the probes below.
+// CODEGEN: probe_find_raw MAX_INSTRUCTIONS 7
+extern "C" auto probe_find_raw(Entry* entries, std::size_t size, std::size_t i) -> Entry* {
+	return i < size ? &entries[i] : nullptr;
+}
+
+// The std::optional baseline of the probes below.
+extern "C" auto probe_find_std_optional(Entry* entries, std::size_t size, std::size_t i) -> std::optional<Entry*> {
+	if (i >= size) {
+		return {};
+	}
+	return &entries[i];
+}
+
+// Returned in a single register like the raw pointer, without using the stack
+// or branches.
+// CODEGEN: probe_find_optional_ref MAX_INSTRUCTIONS 7
+// CODEGEN: probe_find_optional_ref NOT_LONGER_THAN probe_find_std_optional
+// CODEGEN: probe_find_optional_ref NOT_CONTAINS ^call
+// CODEGEN: probe_find_optional_ref NOT_CONTAINS ^j
+// CODEGEN: probe_find_optional_ref NOT_CONTAINS %rsp
+extern "C" auto probe_find_optional_ref(Entry* entries, std::size_t size, std::size_t i) -> optional_ref<Entry> {
+	if (i >= size) {
+		return {};
+	}
+	return &entries[i];
+}
+
+// Checking for a value is a single test or comparison.
+// CODEGEN: probe_has_value MAX_INSTRUCTIONS 3
+// CODEGEN: probe_has_value NOT_CONTAINS ^call
+extern "C" auto probe_has_value(optional_ref<Entry> r) -> bool {
+	return r.has_value();
+}
+
+// CODEGEN: probe_value_or MAX_INSTRUCTIONS 5
+// CODEGEN: probe_value_or NOT_CONTAINS ^call
+extern "C" auto probe_value_or(optional_ref<Entry> r, Entry* fallback) -> Entry* {
+	return r.value_or(fallback);
+}
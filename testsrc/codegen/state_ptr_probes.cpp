@@ -0,0 +1,103 @@
+// Codegen probes for the hot paths of state_ptr and atomic_state_ptr. See
+// check_asm.cmake for the format of the expectations below.
+//
+// These are compiled with NDEBUG so that the default assertion check policy
+// must not leave any trace in the emitted code.
+
+#include <putl/atomic_state_ptr.hpp>
+#include <putl/state_ptr.hpp>
+
+#include <cstdint>
+
+using namespace putl;
+
+struct alignas(8) Node {
+	std::uint64_t value;
+};
+
+using node_ptr = state_ptr<Node>;
+
+// CODEGEN: probe_get_state MAX_INSTRUCTIONS 3
+// CODEGEN: probe_get_state COUNT 1 ^and
+// CODEGEN: probe_get_state NOT_CONTAINS ^call
+// CODEGEN: probe_get_state NOT_CONTAINS ^j
+extern "C" auto probe_get_state(node_ptr p) -> std::uintptr_t {
+	return p.get_state();
+}
+
+// CODEGEN: probe_set_state MAX_INSTRUCTIONS 4
+// CODEGEN: probe_set_state NOT_CONTAINS ^call
+// CODEGEN: probe_set_state NOT_CONTAINS ^j
+extern "C" auto probe_set_state(node_ptr p, std::uintptr_t state) -> node_ptr {
+	p.set_state(state);
+	return p;
+}
+
+// Unchecked construction is a plain OR of pointer and state.
+// CODEGEN: probe_construct_unchecked MAX_INSTRUCTIONS 3
+// CODEGEN: probe_construct_unchecked NOT_CONTAINS ^call
+// CODEGEN: probe_construct_unchecked NOT_CONTAINS ^j
+extern "C" auto probe_construct_unchecked(Node* node, std::uintptr_t state) -> state_ptr<Node, std::uintptr_t, 3, check_policy::unchecked> {
+	return {node, state};
+}
+
+// CODEGEN: probe_deref MAX_INSTRUCTIONS 3
+// CODEGEN: probe_deref NOT_CONTAINS ^call
+extern "C" auto probe_deref(node_ptr p) -> std::uint64_t {
+	return p->value;
+}
+
+// Equality compares the full words.
+// CODEGEN: probe_equal MAX_INSTRUCTIONS 4
+// CODEGEN: probe_equal COUNT 1 ^cmp
+// CODEGEN: probe_equal NOT_CONTAINS ^call
+// CODEGEN: probe_equal NOT_CONTAINS ^and
+extern "C" auto probe_equal(node_ptr lhs, node_ptr rhs) -> bool {
+	return lhs == rhs;
+}
+
+// CODEGEN: probe_less MAX_INSTRUCTIONS 4
+// CODEGEN: probe_less NOT_CONTAINS ^call
+// CODEGEN: probe_less NOT_CONTAINS ^and
+extern "C" auto probe_less(node_ptr lhs, node_ptr rhs) -> bool {
+	return lhs < rhs;
+}
+
+// A compare-exchange is a single lock cmpxchg without calls into libatomic.
+// CODEGEN: probe_atomic_cas COUNT 1 ^lock
+// CODEGEN: probe_atomic_cas CONTAINS ^lock cmpxchg
+// CODEGEN: probe_atomic_cas NOT_CONTAINS ^call
+// CODEGEN: probe_atomic_cas MAX_INSTRUCTIONS 6
+extern "C" auto probe_atomic_cas(atomic_state_ptr<Node>& a, node_ptr expected, node_ptr desired) -> bool {
+	return a.compare_exchange_strong(expected, desired);
+}
+
+// Loads are plain moves on x86-64.
+// CODEGEN: probe_atomic_load MAX_INSTRUCTIONS 2
+// CODEGEN: probe_atomic_load NOT_CONTAINS ^lock
+// CODEGEN: probe_atomic_load NOT_CONTAINS ^call
+extern "C" auto probe_atomic_load(atomic_state_ptr<Node> const& a) -> node_ptr {
+	return a.load(std::memory_order_acquire);
+}
+
+// Setting state bits is a single locked OR if the previous state is unused.
+// CODEGEN: probe_atomic_fetch_or_state NOT_CONTAINS ^call
+// CODEGEN: probe_atomic_fetch_or_state COUNT 1 ^lock
+extern "C" void probe_atomic_fetch_or_state(atomic_state_ptr<Node>& a) {
+	a.fetch_or_state(1);
+}
+
+// Prefetching issues a single hint for the pointee. The compiler may omit
+// stripping the state since it never moves the address to another cache line.
+// CODEGEN: probe_prefetch MAX_INSTRUCTIONS 3
+// CODEGEN: probe_prefetch COUNT 1 ^prefetcht0
+// CODEGEN: probe_prefetch NOT_CONTAINS ^call
+extern "C" void probe_prefetch(node_ptr p) {
+	p.prefetch();
+}
+
+// CODEGEN: probe_prefetch_no_locality COUNT 1 ^prefetchnta
+// CODEGEN: probe_prefetch_no_locality NOT_CONTAINS ^prefetcht
+extern "C" void probe_prefetch_no_locality(node_ptr p) {
+	p.prefetch(prefetch_locality::none);
+}
@@ -0,0 +1,107 @@
+#ifndef UTILS_CONSTEXPR_TESTS_NO_GTEST
+#include <gtest/gtest.h>
+#endif
+
+#include <putl/state_index.hpp>
+#include <putl/state_ptr.hpp>
+
+#include <array>
+#include <cstddef>
+
+// This file is compiled as part of unit_tests and additionally as C++17 and
+// C++20 by the constexpr_tests_cxx17 and constexpr_tests_cxx20 targets.
+// All checks in here happen at compile time.
+
+namespace {
+
+using namespace putl;
+
+struct alignas(8) Handler {
+	int id;
+};
+
+enum class Kind : unsigned { none = 0, leaf = 1, inner = 2, root = 3 };
+
+using kind_ptr = state_ptr<Handler, Kind, 2>;
+
+// -----------------------------------------------------------------------------
+//  Construction, states and set_state.
+// -----------------------------------------------------------------------------
+
+constexpr kind_ptr null_leaf{nullptr, Kind::leaf};
+
+static_assert(null_leaf.get_state() == Kind::leaf, "get_state must be constexpr");
+static_assert(!null_leaf, "operator bool must be constexpr");
+static_assert(null_leaf == nullptr && nullptr == null_leaf, "nullptr comparisons must be constexpr");
+static_assert(!(null_leaf != nullptr) && !(nullptr != null_leaf), "nullptr comparisons must be constexpr");
+
+constexpr auto retagged(kind_ptr p, Kind kind) -> kind_ptr {
+	p.set_state(kind);
+	return p;
+}
+
+static_assert(retagged(null_leaf, Kind::root).get_state() == Kind::root, "set_state must be constexpr");
+
+// -----------------------------------------------------------------------------
+//  Comparisons and hashing.
+// -----------------------------------------------------------------------------
+
+constexpr kind_ptr null_inner{nullptr, Kind::inner};
+
+static_assert(null_leaf == null_leaf && null_leaf != null_inner, "equality must be constexpr");
+static_assert(null_leaf < null_inner && null_leaf <= null_inner, "relational operators must be constexpr");
+static_assert(null_inner > null_leaf && null_inner >= null_leaf, "relational operators must be constexpr");
+static_assert(std::hash<kind_ptr>{}(null_leaf) != std::hash<kind_ptr>{}(null_inner), "hashing must be constexpr");
+
+// -----------------------------------------------------------------------------
+//  Check policies.
+// -----------------------------------------------------------------------------
+
+static_assert(state_ptr<Handler, unsigned, 3, check_policy::unchecked>{nullptr, 7}.get_state() == 7, "unchecked construction must be constexpr");
+static_assert(state_ptr<Handler, unsigned, 3, check_policy::exception>{nullptr, 7}.get_state() == 7, "checked construction must be constexpr");
+
+// -----------------------------------------------------------------------------
+//  Static tables: constexpr variables are constant-initialized and therefore
+//  require no dynamic initialization.
+// -----------------------------------------------------------------------------
+
+constexpr std::array<kind_ptr, 3> kind_table{{
+	{nullptr, Kind::none},
+	{nullptr, Kind::leaf},
+	{nullptr, Kind::root},
+}};
+
+static_assert(kind_table[2].get_state() == Kind::root, "tables of state_ptr must be constant-initialized");
+
+using handler_index = state_index<std::array<Handler, 4>, Kind, 2>;
+
+constexpr std::array<Handler, 4> handlers{{{10}, {11}, {12}, {13}}};
+
+constexpr std::array<handler_index, 3> dispatch_table{{
+	{3, Kind::root},
+	{1, Kind::leaf},
+	handler_index::null(Kind::none),
+}};
+
+static_assert(dispatch_table[0].get(handlers).id == 13, "dispatch tables of state_index must be constant-initialized");
+static_assert(dispatch_table[1].get_state() == Kind::leaf, "dispatch tables of state_index must be constant-initialized");
+static_assert(dispatch_table[2].is_null(), "dispatch tables of state_index must be constant-initialized");
+
+#if defined(__cpp_constinit)
+// constinit is ill-formed if the variable requires dynamic initialization.
+constinit kind_ptr mutable_null_leaf{nullptr, Kind::leaf};
+constinit handler_index mutable_dispatch{2, Kind::inner};
+#endif
+
+#if UTILS_STATE_PTR_HAS_THREE_WAY_COMPARISON
+static_assert((null_leaf <=> null_inner) < 0, "operator<=> must be constexpr");
+#endif
+
+#ifndef UTILS_CONSTEXPR_TESTS_NO_GTEST
+TEST(Constexpr, TablesAreUsableAtRunTime) {
+	EXPECT_EQ(kind_table[1].get_state(), Kind::leaf);
+	EXPECT_EQ(dispatch_table[0].get(handlers).id, 13);
+}
+#endif
+
+} // namespace
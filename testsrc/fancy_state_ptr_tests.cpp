@@ -0,0 +1,244 @@
+#include <gtest/gtest.h>
+
+#include <putl/fancy_state_ptr.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace putl;
+
+/// \brief An element type whose size is not a power of two.
+struct Rgb {
+	unsigned char r, g, b;
+};
+
+/// \brief An element type whose size is not a power of two but a multiple of its alignment.
+struct alignas(4) Vec3 {
+	float x, y, z;
+};
+
+/// \brief A minimal allocator-aware singly linked list storing its links as
+///        `allocator_traits::pointer`, like node-based standard containers.
+template<typename T, typename Alloc>
+class ForwardList {
+	struct Node;
+	using node_alloc  = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+	using node_traits = std::allocator_traits<node_alloc>;
+
+public:
+	using node_pointer = typename node_traits::pointer;
+
+	~ForwardList() {
+		while (m_head) {
+			auto next = m_head->next;
+			node_traits::destroy(m_alloc, to_address(m_head));
+			node_traits::deallocate(m_alloc, m_head, 1);
+			m_head = next;
+		}
+	}
+
+	void push_front(T value) {
+		auto node = node_traits::allocate(m_alloc, 1);
+		node_traits::construct(m_alloc, to_address(node), Node{m_head, value});
+		m_head = node;
+	}
+
+	auto head() const -> node_pointer { return m_head; }
+
+private:
+	struct Node {
+		node_pointer next;
+		T            value;
+	};
+
+	node_alloc   m_alloc;
+	node_pointer m_head = nullptr;
+};
+
+TEST(FancyStatePointer, NullablePointer) {
+	fancy_state_ptr<int> p;
+	fancy_state_ptr<int> q{nullptr};
+	EXPECT_EQ(p, nullptr);
+	EXPECT_EQ(nullptr, q);
+	EXPECT_EQ(p, q);
+	EXPECT_FALSE(p);
+}
+
+TEST(FancyStatePointer, StateSurvivesVoidRoundTrip) {
+	int foo{42};
+	fancy_state_ptr<int, 2> p{&foo, 3};
+	fancy_state_ptr<void, 2> v = p;
+	auto q = static_cast<fancy_state_ptr<int, 2>>(v);
+	EXPECT_EQ(q.get_ptr(), &foo);
+	EXPECT_EQ(q.get_state(), 3u);
+	fancy_state_ptr<int const, 2> c = q;
+	EXPECT_EQ(*c, 42);
+	EXPECT_EQ(c.get_state(), 3u);
+}
+
+TEST(FancyStatePointer, EqualityIgnoresState) {
+	int foo{42};
+	fancy_state_ptr<int> p{&foo, 0};
+	fancy_state_ptr<int> q{&foo, 1};
+	EXPECT_EQ(p, q);
+	EXPECT_FALSE(p < q);
+	EXPECT_FALSE(q < p);
+}
+
+TEST(FancyStatePointer, RandomAccess) {
+	int values[4] = {1, 2, 3, 4};
+	fancy_state_ptr<int> p{values, 1};
+	EXPECT_EQ(p[2], 3);
+	auto q = p + 3;
+	EXPECT_EQ(*q, 4);
+	EXPECT_EQ(q.get_state(), 1u);
+	EXPECT_EQ(q - p, 3);
+	EXPECT_TRUE(p < q);
+	--q;
+	EXPECT_EQ(*q, 3);
+}
+
+TEST(FancyStatePointer, ArithmeticKeepsStateOfAlignedElements) {
+	std::uint64_t values[4] = {1, 2, 3, 4};
+	fancy_state_ptr<std::uint64_t, 3> p{values, 5};
+	for (std::size_t i = 0; i < 4; ++i, ++p) {
+		EXPECT_EQ(p.get_ptr(), &values[i]);
+		EXPECT_EQ(p.get_state(), 5u);
+		EXPECT_EQ(*p, i + 1);
+	}
+	p -= 3;
+	EXPECT_EQ(p.get_ptr(), &values[1]);
+	EXPECT_EQ(p.get_state(), 5u);
+}
+
+TEST(FancyStatePointer, OddSizedElements) {
+	Vec3 values[3] = {{1, 0, 0}, {2, 0, 0}, {3, 0, 0}};
+	fancy_state_ptr<Vec3, 2> p{values, 3};
+	EXPECT_EQ((p + 2)->x, 3.0f);
+	EXPECT_EQ((p + 2).get_state(), 3u);
+	EXPECT_EQ((p + 2) - p, 2);
+	++p;
+	EXPECT_EQ(p.get_ptr(), &values[1]);
+	EXPECT_EQ(p.get_state(), 3u);
+}
+
+TEST(FancyStatePointer, PointerTraits) {
+	using traits = std::pointer_traits<fancy_state_ptr<int, 2>>;
+	static_assert(std::is_same<traits::rebind<long>, fancy_state_ptr<long, 2>>::value, "");
+	int foo{42};
+	auto p = traits::pointer_to(foo);
+	EXPECT_EQ(traits::to_address(p), &foo);
+	EXPECT_EQ(putl::to_address(p), &foo);
+}
+
+TEST(StateAllocator, AllocatorTraits) {
+	using traits = std::allocator_traits<state_allocator<int>>;
+	static_assert(std::is_same<traits::pointer, fancy_state_ptr<int>>::value, "");
+	static_assert(std::is_same<traits::void_pointer, fancy_state_ptr<void>>::value, "");
+	static_assert(std::is_same<traits::rebind_alloc<long>, state_allocator<long>>::value, "");
+	state_allocator<int> alloc;
+	auto p = traits::allocate(alloc, 4);
+	EXPECT_EQ(p.get_state(), 0u);
+	p.set_state(1);
+	traits::deallocate(alloc, p, 4);
+}
+
+TEST(StateAllocator, Vector) {
+	std::vector<int, state_allocator<int>> vec;
+	for (int i = 0; i < 100; ++i) {
+		vec.push_back(i);
+	}
+	EXPECT_EQ(vec[42], 42);
+	EXPECT_EQ(vec.size(), 100u);
+}
+
+TEST(StateAllocator, CharVector) {
+	// The alignment of char leaves no room for state bits.
+	std::vector<char, state_allocator<char, 0>> vec{'a', 'b', 'c', 'd'};
+	EXPECT_EQ(std::string(vec.begin(), vec.end()), "abcd");
+	vec.push_back('e');
+	EXPECT_EQ(vec.end() - vec.begin(), 5);
+	EXPECT_EQ(vec.back(), 'e');
+}
+
+TEST(StateAllocator, IntVector) {
+	std::vector<int, state_allocator<int, 2>> vec{1, 2, 3};
+	std::vector<int> copy;
+	for (auto it = vec.begin(); it != vec.end(); ++it) {
+		copy.push_back(*it);
+	}
+	EXPECT_EQ(copy, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(StateAllocator, OddSizedVectors) {
+	std::vector<Rgb, state_allocator<Rgb, 0>> rgb{{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+	EXPECT_EQ(rgb[1].g, 5);
+	EXPECT_EQ(rgb.end() - rgb.begin(), 3);
+	std::vector<Vec3, state_allocator<Vec3, 2>> vec3{{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+	EXPECT_EQ(vec3[2].z, 9.0f);
+	EXPECT_EQ(vec3.end() - vec3.begin(), 3);
+}
+
+TEST(StateAllocator, RejectsOversizedAllocation) {
+	using allocator = state_allocator<Vec3, 2>;
+	allocator alloc;
+	EXPECT_EQ(alloc.max_size(), std::numeric_limits<std::size_t>::max() / sizeof(Vec3));
+	EXPECT_EQ(std::allocator_traits<allocator>::max_size(alloc), alloc.max_size());
+	EXPECT_THROW(alloc.allocate(alloc.max_size() + 1), std::bad_array_new_length);
+}
+
+#if defined(__cpp_aligned_new)
+TEST(StateAllocator, OverAligned) {
+	struct alignas(64) Line {
+		char bytes[64];
+	};
+	state_allocator<Line, 6> alloc;
+	auto p = alloc.allocate(3);
+	EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p.get_ptr()) % 64, 0u);
+	p.set_state(63);
+	EXPECT_EQ((p + 2).get_state(), 63u);
+	alloc.deallocate(p, 3);
+}
+#endif
+
+TEST(StateAllocator, LinksCarryStates) {
+	ForwardList<int, state_allocator<int, 3>> list;
+	for (int i = 0; i < 10; ++i) {
+		list.push_front(i);
+	}
+	auto count = 0;
+	for (auto p = list.head(); p; p = p->next) {
+		p->next.set_state(static_cast<std::uintptr_t>(p->value % 8));
+		++count;
+	}
+	EXPECT_EQ(count, 10);
+	for (auto p = list.head(); p; p = p->next) {
+		EXPECT_EQ(p->next.get_state(), static_cast<std::uintptr_t>(p->value % 8));
+	}
+}
+
+// libstdc++ stores the links of std::list and std::map as raw pointers and thus
+// does not support fancy pointers for these containers, while libc++ does.
+#if defined(_LIBCPP_VERSION)
+TEST(StateAllocator, NodeContainers) {
+	std::list<int, state_allocator<int>> list;
+	std::map<int, int, std::less<int>, state_allocator<std::pair<int const, int>>> map;
+	for (int i = 0; i < 100; ++i) {
+		list.push_back(i);
+		map.emplace(i, i * i);
+	}
+	EXPECT_EQ(list.size(), 100u);
+	EXPECT_EQ(map.at(9), 81);
+}
+#endif
+
+} // namespace
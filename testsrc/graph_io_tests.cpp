@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+
+#include <putl/graph_io.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+using namespace putl;
+
+enum Color : std::uintptr_t { Red = 0, Black = 1 };
+
+struct TreeNode {
+	long                          key;
+	state_ptr<TreeNode, Color, 1> left;
+	state_ptr<TreeNode, Color, 1> right;
+};
+
+struct Leaf {
+	double value;
+};
+
+struct Holder {
+	int                                  id;
+	state_ptr<Leaf, int>                 leaf;
+	state_ptr<Holder, std::uintptr_t, 2> next;
+};
+
+struct CheckedNode {
+	int                                                         id;
+	state_ptr<CheckedNode, Color, 1, check_policy::exception>   next;
+	state_ptr<Leaf, int, 2, check_policy::sampled<4>>           leaf;
+};
+
+auto make_schema() -> graph_schema {
+	graph_schema schema;
+	schema.add<TreeNode>(&TreeNode::left, &TreeNode::right);
+	schema.add<Leaf>();
+	schema.add<Holder>(&Holder::leaf, &Holder::next);
+	schema.add<CheckedNode>(&CheckedNode::next, &CheckedNode::leaf);
+	return schema;
+}
+
+/// \brief Returns the image of a tree of two nodes and the offset of its root.
+auto make_tree_image(graph_schema const& schema, std::uint64_t& root_offset) -> std::vector<char> {
+	static TreeNode l{1, {nullptr, Red}, {nullptr, Red}};
+	static TreeNode root{2, {&l, Black}, {nullptr, Red}};
+	graph_writer writer{schema};
+	writer.add_root(&root);
+	auto buffer = writer.write();
+	std::memcpy(&root_offset, buffer.data() + sizeof(detail::graph_image_header), sizeof(root_offset));
+	return buffer;
+}
+
+void write_u64(std::vector<char>& buffer, std::uint64_t at, std::uint64_t value) {
+	std::memcpy(buffer.data() + at, &value, sizeof(value));
+}
+
+TEST(GraphIO, RoundTripKeepsStates) {
+	TreeNode l{1, {nullptr, Black}, {nullptr, Red}};
+	TreeNode r{3, {nullptr, Red}, {nullptr, Black}};
+	TreeNode root{2, {&l, Red}, {&r, Black}};
+
+	auto const schema = make_schema();
+	graph_writer writer{schema};
+	writer.add_root(&root);
+	graph_image image{writer.write()};
+
+	graph_reader reader{schema, image};
+	ASSERT_EQ(reader.root_count(), 1u);
+	auto const n = reader.root<TreeNode>(0);
+	ASSERT_NE(n, nullptr);
+	EXPECT_EQ(n->key, 2);
+	EXPECT_EQ(n->left.get_state(), Red);
+	EXPECT_EQ(n->right.get_state(), Black);
+	auto const nl = reader.follow(n->left);
+	auto const nr = reader.follow(n->right);
+	EXPECT_EQ(nl->key, 1);
+	EXPECT_EQ(nr->key, 3);
+	EXPECT_EQ(nl->left, nullptr);
+	EXPECT_EQ(nl->left.get_state(), Black);
+	EXPECT_EQ(nr->right.get_state(), Black);
+}
+
+TEST(GraphIO, SharedNodesAndCycles) {
+	Leaf leaf{4.5};
+	Holder a{1, {&leaf, 1}, {nullptr, 0}};
+	Holder b{2, {&leaf, 3}, {&a, 1}};
+	a.next = state_ptr<Holder, std::uintptr_t, 2>{&b, 2};
+
+	auto const schema = make_schema();
+	graph_writer writer{schema};
+	writer.add_root(&a);
+	writer.add_root(&b);
+	graph_image image{writer.write()};
+
+	graph_reader reader{schema, image};
+	reader.swizzle_all();
+	auto const ra = reader.root<Holder>(0);
+	auto const rb = reader.root<Holder>(1);
+	EXPECT_EQ(ra->next.get_ptr(), rb);
+	EXPECT_EQ(rb->next.get_ptr(), ra);
+	EXPECT_EQ(ra->next.get_state(), 2u);
+	EXPECT_EQ(ra->leaf.get_ptr(), rb->leaf.get_ptr());
+	EXPECT_EQ(ra->leaf.get_state(), 1);
+	EXPECT_EQ(rb->leaf.get_state(), 3);
+	EXPECT_EQ(reader.follow(ra->leaf)->value, 4.5);
+}
+
+/// \brief Provides an image file path unique to the test process within the
+///        temporary directory, so that the test executables built from these
+///        sources do not race when run concurrently, and removes the file.
+class GraphIOFile : public ::testing::Test {
+protected:
+	void SetUp() override {
+		auto dir = std::string{};
+		for (auto const var : {"TMPDIR", "TMP", "TEMP"}) {
+			if (auto const value = std::getenv(var)) {
+				dir = value;
+				break;
+			}
+		}
+		if (dir.empty()) {
+#if defined(_WIN32)
+			dir = ".";
+#else
+			dir = "/tmp";
+#endif
+		}
+#if defined(_WIN32)
+		auto const pid = _getpid();
+#else
+		auto const pid = getpid();
+#endif
+		path = dir + "/graph_io_tests." + std::to_string(pid) + ".img";
+	}
+
+	void TearDown() override {
+		std::remove(path.c_str());
+	}
+
+	std::string path;
+};
+
+TEST_F(GraphIOFile, MapFile) {
+	TreeNode l{1, {nullptr, Red}, {nullptr, Red}};
+	TreeNode root{2, {&l, Black}, {nullptr, Black}};
+	auto const schema = make_schema();
+	graph_writer writer{schema};
+	writer.add_root(&root);
+	writer.write_file(path);
+	{
+		auto image = graph_image::map_file(path);
+		graph_reader reader{schema, image};
+		auto const n = reader.root<TreeNode>(0);
+		EXPECT_EQ(reader.follow(n->left)->key, 1);
+		EXPECT_EQ(n->left.get_state(), Black);
+	}
+}
+
+TEST(GraphIO, RejectsMalformedImage) {
+	auto const schema = make_schema();
+	graph_image image{std::vector<char>(64, 0)};
+	EXPECT_THROW((graph_reader{schema, image}), std::runtime_error);
+}
+
+TEST(GraphIO, RejectsRootIndexOutOfBounds) {
+	auto const schema = make_schema();
+	std::uint64_t offset;
+	graph_image image{make_tree_image(schema, offset)};
+	graph_reader reader{schema, image};
+	EXPECT_THROW(reader.root<TreeNode>(1), std::out_of_range);
+}
+
+TEST(GraphIO, RejectsCorruptedRootOffset) {
+	auto const schema = make_schema();
+	std::uint64_t offset;
+	auto const buffer = make_tree_image(schema, offset);
+	auto const root_at = sizeof(detail::graph_image_header);
+	for (auto const bad : {std::uint64_t{8}, offset + 4, std::uint64_t{buffer.size()}, std::uint64_t{1} << 40}) {
+		auto corrupted = buffer;
+		write_u64(corrupted, root_at, bad);
+		graph_image image{std::move(corrupted)};
+		graph_reader reader{schema, image};
+		EXPECT_THROW(reader.root<TreeNode>(0), std::runtime_error) << "root offset " << bad;
+		EXPECT_THROW(reader.swizzle_all(), std::runtime_error) << "root offset " << bad;
+	}
+}
+
+TEST(GraphIO, RejectsCorruptedObjectType) {
+	auto const schema = make_schema();
+	std::uint64_t offset;
+	auto corrupted = make_tree_image(schema, offset);
+	auto const type = std::uint32_t{1000};
+	std::memcpy(corrupted.data() + offset - sizeof(detail::graph_object_header), &type, sizeof(type));
+	graph_image image{std::move(corrupted)};
+	graph_reader reader{schema, image};
+	EXPECT_THROW(reader.root<TreeNode>(0), std::runtime_error);
+	EXPECT_THROW(reader.swizzle_all(), std::runtime_error);
+}
+
+TEST(GraphIO, RejectsRootOfDifferentType) {
+	auto const schema = make_schema();
+	std::uint64_t offset;
+	graph_image image{make_tree_image(schema, offset)};
+	graph_reader reader{schema, image};
+	EXPECT_THROW(reader.root<Holder>(0), std::runtime_error);
+}
+
+TEST(GraphIO, RejectsCorruptedLink) {
+	auto const schema = make_schema();
+	std::uint64_t offset;
+	auto const buffer = make_tree_image(schema, offset);
+	auto const left_at = offset + offsetof(TreeNode, left);
+	std::uint64_t left;
+	std::memcpy(&left, buffer.data() + left_at, sizeof(left));
+	// Out of bounds, before the objects, misaligned and pointing into the middle of an object.
+	for (auto const bad : {std::uint64_t{buffer.size()} << 1, std::uint64_t{16}, left + 4, offset + 8}) {
+		auto corrupted = buffer;
+		write_u64(corrupted, left_at, bad | Black);
+		graph_image image{std::move(corrupted)};
+		graph_reader reader{schema, image};
+		EXPECT_THROW(reader.root<TreeNode>(0), std::runtime_error) << "link offset " << bad;
+		// The malformed object is left untouched.
+		std::uint64_t link;
+		std::memcpy(&link, image.data() + left_at, sizeof(link));
+		EXPECT_EQ(link, bad | Black);
+	}
+}
+
+TEST(GraphIO, LinksWithNonDefaultCheckPolicy) {
+	Leaf leaf{1.5};
+	CheckedNode b{2, {nullptr, Red}, {&leaf, 3}};
+	CheckedNode a{1, {&b, Black}, {nullptr, 1}};
+
+	auto const schema = make_schema();
+	graph_writer writer{schema};
+	writer.add_root(&a);
+	graph_image image{writer.write()};
+
+	graph_reader reader{schema, image};
+	auto const ra = reader.root<CheckedNode>(0);
+	EXPECT_EQ(ra->next.get_state(), Black);
+	EXPECT_EQ(ra->leaf, nullptr);
+	EXPECT_EQ(ra->leaf.get_state(), 1);
+	auto const rb = reader.follow(ra->next);
+	EXPECT_EQ(rb->id, 2);
+	EXPECT_EQ(rb->leaf.get_state(), 3);
+	EXPECT_EQ(reader.follow(rb->leaf)->value, 1.5);
+	EXPECT_THROW(rb->next.set_state(static_cast<Color>(2)), std::out_of_range);
+}
+
+} // namespace
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include <putl/high_state_ptr.hpp>
+
+#include <unordered_set>
+
+namespace {
+
+using namespace putl;
+
+TEST(HighStatePointer, InitializedAsNull) {
+	high_state_ptr<char> p{nullptr, 0};
+	EXPECT_EQ(p, nullptr);
+	EXPECT_FALSE(p);
+}
+
+TEST(HighStatePointer, WideStateOnUnalignedType) {
+	char c{'x'};
+	high_state_ptr<char> p{&c, 0xBEEF};
+	EXPECT_EQ(p.get_ptr(), &c);
+	EXPECT_EQ(p.get_state(), 0xBEEFu);
+	EXPECT_EQ(*p, 'x');
+	p.set_state(0xFFFF);
+	EXPECT_EQ(p.get_ptr(), &c);
+	EXPECT_EQ(p.get_state(), 0xFFFFu);
+}
+
+TEST(HighStatePointer, Equality) {
+	int foo{1};
+	high_state_ptr<int, std::uintptr_t, 8> p1{&foo, 1};
+	high_state_ptr<int, std::uintptr_t, 8> p2{&foo, 1};
+	high_state_ptr<int, std::uintptr_t, 8> p3{&foo, 2};
+	EXPECT_EQ(p1, p2);
+	EXPECT_NE(p1, p3);
+	std::unordered_set<high_state_ptr<int, std::uintptr_t, 8>> set{p1, p2, p3};
+	EXPECT_EQ(set.size(), 2u);
+}
+
+TEST(HighStatePointer, SetStateOutOfBounds) {
+	int foo{1};
+	high_state_ptr<int, std::uintptr_t, 4> p{&foo, 0};
+	ASSERT_DEATH(p.set_state(16), "state value is out of bounds for this high_state_ptr");
+}
+
+} // namespace
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <putl/interned_str.hpp>
+
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+using namespace putl;
+
+TEST(InternedString, PointerSized) {
+#if !UTILS_STATE_PTR_SEPARATE_FIELDS
+	static_assert(sizeof(interned_str) == sizeof(void*), "");
+#endif
+}
+
+TEST(InternedString, DefaultIsEmpty) {
+	interned_str s;
+	EXPECT_TRUE(s.empty());
+	EXPECT_EQ(s.size(), 0u);
+	EXPECT_STREQ(s.c_str(), "");
+}
+
+TEST(Interner, EqualStringsShareHandle) {
+	interner strings;
+	auto a = strings.intern("hello");
+	auto b = strings.intern(std::string{"hel"} + "lo");
+	auto c = strings.intern("world");
+	EXPECT_EQ(a, b);
+	EXPECT_NE(a, c);
+	EXPECT_EQ(a.str(), "hello");
+	EXPECT_EQ(a.size(), 5u);
+	EXPECT_EQ(c.str(), "world");
+	EXPECT_EQ(strings.size(), 2u);
+	EXPECT_EQ(strings.intern(""), interned_str{});
+}
+
+TEST(Interner, HashFragment) {
+	interner strings;
+	auto a = strings.intern("symbol");
+	EXPECT_EQ(a.hash(), detail::fnv1a("symbol", 6));
+	EXPECT_EQ(a.hash_fragment(), a.hash() >> 48);
+}
+
+TEST(Interner, ManyStrings) {
+	interner strings;
+	std::vector<interned_str> handles;
+	for (int i = 0; i < 10000; ++i) {
+		handles.push_back(strings.intern("sym_" + std::to_string(i)));
+	}
+	EXPECT_EQ(strings.size(), 10000u);
+	for (int i = 0; i < 10000; ++i) {
+		EXPECT_EQ(strings.intern("sym_" + std::to_string(i)), handles[static_cast<std::size_t>(i)]);
+	}
+	std::unordered_set<interned_str> set(handles.begin(), handles.end());
+	EXPECT_EQ(set.size(), 10000u);
+}
+
+TEST(ConcurrentInterner, ParallelIntern) {
+	concurrent_interner strings{4};
+	std::vector<std::vector<interned_str>> results(4);
+	std::vector<std::thread> threads;
+	for (std::size_t t = 0; t < 4; ++t) {
+		threads.emplace_back([&strings, &results, t] {
+			for (int i = 0; i < 1000; ++i) {
+				results[t].push_back(strings.intern("sym_" + std::to_string(i)));
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	EXPECT_EQ(strings.size(), 1000u);
+	for (std::size_t t = 1; t < 4; ++t) {
+		EXPECT_EQ(results[t], results[0]);
+	}
+}
+
+} // namespace
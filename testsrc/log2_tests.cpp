@@ -2,6 +2,9 @@
 
 #include <putl/state_ptr.hpp>
 
+#include <cstddef>
+#include <cstdint>
+
 namespace {
 
 using namespace putl;
@@ -33,4 +36,39 @@ TEST(ConstexprLog2, Odd) {
 	EXPECT_EQ(detail::log2(35), 5);
 }
 
+TEST(ConstexprLog2, Wide) {
+	EXPECT_EQ(detail::log2(std::uint64_t{1} << 40), std::uint64_t{40});
+	EXPECT_EQ(detail::log2(~std::uint64_t{0}), std::uint64_t{63});
+	EXPECT_EQ(detail::log2(std::size_t{4096}), std::size_t{12});
+}
+
+TEST(ConstexprLog2, CompileTime) {
+	static_assert(detail::log2(std::size_t{1}) == 0, "");
+	static_assert(detail::log2(std::size_t{64}) == 6, "");
+	static_assert(detail::log2(std::size_t{65}) == 6, "");
+	static_assert(detail::bit_width(0) == 0, "");
+	static_assert(detail::bit_width(1) == 1, "");
+	static_assert(detail::bit_width(255) == 8, "");
+	static_assert(detail::bit_width(256) == 9, "");
+	static_assert(detail::bit_width(~std::uint64_t{0}) == 64, "");
+}
+
+TEST(AlignmentBits, PowersOfTwo) {
+	static_assert(alignment_bits(1) == 0, "");
+	static_assert(alignment_bits(alignof(std::uint64_t)) == detail::log2(alignof(std::uint64_t)), "");
+	for (std::size_t bits = 0; bits < 8 * sizeof(std::size_t); ++bits) {
+		EXPECT_EQ(alignment_bits(std::size_t{1} << bits), bits);
+	}
+}
+
+TEST(AlignmentBits, RuntimeAlignment) {
+	volatile std::size_t arena_alignment = 4096;
+	EXPECT_EQ(alignment_bits(arena_alignment), 12u);
+}
+
+TEST(AlignmentBits, RejectsNonPowersOfTwo) {
+	ASSERT_DEATH(alignment_bits(0), "alignment must be a power of two");
+	ASSERT_DEATH(alignment_bits(24), "alignment must be a power of two");
+}
+
 } // namespace
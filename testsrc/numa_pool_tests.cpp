@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <putl/numa_pool.hpp>
+
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace putl;
+
+struct Node {
+	long value;
+	Node* next;
+};
+
+TEST(NumaPool, DetectsAtLeastOneNode) {
+	numa_pool<Node> pool;
+	EXPECT_GE(pool.node_count(), 1u);
+}
+
+TEST(NumaPool, AllocationsAreTaggedWithHomeNode) {
+	numa_pool<Node> pool{4, 16};
+	for (std::size_t node = 0; node < 4; ++node) {
+		auto p = pool.create(node, Node{static_cast<long>(node), nullptr});
+		EXPECT_EQ(p.get_state(), node);
+		EXPECT_EQ(p->value, static_cast<long>(node));
+		pool.destroy(p);
+	}
+}
+
+TEST(NumaPool, DeallocateRoutesToHomeNode) {
+	numa_pool<Node> pool{2, 16};
+	auto p = pool.allocate(1);
+	auto const addr = p.get_ptr();
+	pool.deallocate(p);
+	EXPECT_NE(pool.allocate(0).get_ptr(), addr);
+	EXPECT_EQ(pool.allocate(1).get_ptr(), addr);
+}
+
+TEST(NumaPool, RemoteFrees) {
+	numa_pool<Node> pool{4, 64};
+	std::vector<numa_pool<Node>::pointer> ptrs;
+	for (std::size_t i = 0; i < 1000; ++i) {
+		ptrs.push_back(pool.allocate(i % 4));
+	}
+	std::vector<std::thread> threads;
+	for (std::size_t t = 0; t < 4; ++t) {
+		threads.emplace_back([&pool, &ptrs, t] {
+			for (std::size_t i = t; i < ptrs.size(); i += 4) {
+				pool.deallocate(ptrs[(i + 1) % ptrs.size()]);
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+TEST(NumaPool, PartitionByNode) {
+	numa_pool<Node> pool{3, 16};
+	std::vector<numa_pool<Node>::pointer> ptrs;
+	for (std::size_t i = 0; i < 10; ++i) {
+		ptrs.push_back(pool.allocate((i * 2) % 3));
+	}
+	auto const offsets = partition_by_node(ptrs.begin(), ptrs.end(), 3);
+	ASSERT_EQ(offsets.size(), 4u);
+	EXPECT_EQ(offsets[0], 0u);
+	EXPECT_EQ(offsets[3], ptrs.size());
+	for (std::size_t node = 0; node < 3; ++node) {
+		for (auto i = offsets[node]; i < offsets[node + 1]; ++i) {
+			EXPECT_EQ(ptrs[i].get_state(), node);
+		}
+	}
+	for (auto p : ptrs) {
+		pool.deallocate(p);
+	}
+}
+
+TEST(NumaPool, PartitionByNodeRejectsUnknownNodes) {
+	Node node{};
+	std::vector<numa_pool<Node>::pointer> ptrs = {{&node, 1}, {&node, 5}};
+	ASSERT_DEATH(partition_by_node(ptrs.begin(), ptrs.end(), 3), "node state is out of bounds for partition_by_node");
+}
+
+} // namespace
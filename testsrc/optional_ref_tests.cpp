@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <putl/optional_ref.hpp>
+
+#include <type_traits>
+
+namespace {
+
+using namespace putl;
+
+#if !UTILS_STATE_PTR_SEPARATE_FIELDS
+static_assert(sizeof(optional_ref<int>)  == sizeof(int*),  "optional_ref must be pointer-sized");
+static_assert(sizeof(optional_ref<char>) == sizeof(char*), "optional_ref must be pointer-sized");
+#endif
+static_assert(std::is_trivially_copyable<optional_ref<int>>::value,  "optional_ref must be trivially copyable");
+static_assert(std::is_trivially_copyable<optional_ref<char>>::value, "optional_ref must be trivially copyable");
+
+TEST(OptionalRef, DefaultIsAbsent) {
+	optional_ref<int> r;
+	EXPECT_FALSE(r.has_value());
+	EXPECT_FALSE(r);
+}
+
+TEST(OptionalRef, PresentButNull) {
+	optional_ref<int> r{static_cast<int*>(nullptr)};
+	EXPECT_TRUE(r.has_value());
+	EXPECT_EQ(r.value(), nullptr);
+	EXPECT_NE(r, optional_ref<int>{});
+}
+
+TEST(OptionalRef, Present) {
+	int foo{42};
+	optional_ref<int> r{foo};
+	EXPECT_TRUE(r);
+	EXPECT_EQ(*r, &foo);
+	EXPECT_EQ(**r, 42);
+	r.reset();
+	EXPECT_FALSE(r);
+}
+
+TEST(OptionalRef, ValueOr) {
+	int foo{42};
+	int bar{1337};
+	optional_ref<int> absent;
+	optional_ref<int> present{&foo};
+	EXPECT_EQ(absent.value_or(&bar), &bar);
+	EXPECT_EQ(present.value_or(&bar), &foo);
+}
+
+TEST(OptionalRef, UnalignedType) {
+	char c{'x'};
+	optional_ref<char> absent;
+	optional_ref<char> null{static_cast<char*>(nullptr)};
+	optional_ref<char> present{c};
+	EXPECT_FALSE(absent);
+	EXPECT_TRUE(null);
+	EXPECT_EQ(null.value(), nullptr);
+	EXPECT_TRUE(present);
+	EXPECT_EQ(*present.value(), 'x');
+}
+
+TEST(OptionalRef, ValueOfAbsent) {
+	optional_ref<int> r;
+	ASSERT_DEATH(r.value(), "accessed the value of an absent optional_ref");
+}
+
+} // namespace
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <putl/packed48_vector.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using namespace putl;
+
+TEST(Packed48Vector, PushBackAndRandomAccess) {
+	std::vector<long> values(100);
+	packed48_vector<long> vec;
+	for (std::size_t i = 0; i < values.size(); ++i) {
+		vec.push_back(state_ptr<long>{&values[i], i % 8});
+	}
+	ASSERT_EQ(vec.size(), values.size());
+	for (std::size_t i = 0; i < values.size(); ++i) {
+		EXPECT_EQ(vec[i].get_ptr(), &values[i]);
+		EXPECT_EQ(vec[i].get_state(), i % 8);
+	}
+}
+
+TEST(Packed48Vector, Set) {
+	long a{1};
+	long b{2};
+	packed48_vector<long> vec;
+	vec.push_back(state_ptr<long>{&a, 1});
+	vec.push_back(state_ptr<long>{&a, 2});
+	vec.set(0, state_ptr<long>{&b, 7});
+	EXPECT_EQ(vec[0].get_ptr(), &b);
+	EXPECT_EQ(vec[0].get_state(), 7u);
+	EXPECT_EQ(vec[1].get_ptr(), &a);
+	EXPECT_EQ(vec[1].get_state(), 2u);
+}
+
+TEST(Packed48Vector, RejectsPointersWiderThan48Bits) {
+	long a{1};
+	auto const wide = state_ptr<long>::from_raw(std::uintptr_t{1} << 52);
+	packed48_vector<long> vec;
+	vec.push_back(state_ptr<long>{&a, 3});
+	EXPECT_THROW(vec.push_back(wide), std::invalid_argument);
+	EXPECT_EQ(vec.size(), 1u);
+	EXPECT_THROW(vec.set(0, wide), std::invalid_argument);
+	EXPECT_EQ(vec[0].get_ptr(), &a);
+	EXPECT_EQ(vec[0].get_state(), 3u);
+}
+
+TEST(Packed48Vector, DecodeMatchesRandomAccess) {
+	std::vector<int> values(1000);
+	packed48_vector<int> vec;
+	for (std::size_t i = 0; i < values.size(); ++i) {
+		vec.push_back(state_ptr<int>{&values[i], i % 4});
+	}
+	std::vector<state_ptr<int>> out(997, state_ptr<int>{nullptr, 0});
+	vec.decode(3, out.size(), out.data());
+	for (std::size_t i = 0; i < out.size(); ++i) {
+		EXPECT_EQ(out[i], vec[i + 3]);
+	}
+	std::size_t index = 0;
+	vec.for_each([&](state_ptr<int> const& p) {
+		EXPECT_EQ(p.get_ptr(), &values[index]);
+		++index;
+	});
+	EXPECT_EQ(index, values.size());
+}
+
+TEST(Packed48Vector, ScalarAndSimdKernelsAgree) {
+	std::vector<unsigned char> bytes(6 * 37 + 16);
+	for (std::size_t i = 0; i < bytes.size(); ++i) {
+		bytes[i] = static_cast<unsigned char>(i * 31 + 7);
+	}
+	std::vector<std::uint64_t> scalar(37);
+	std::vector<std::uint64_t> fast(37);
+	detail::unpack48_scalar(bytes.data(), 37, scalar.data());
+	detail::unpack48(bytes.data(), 37, fast.data());
+	EXPECT_EQ(scalar, fast);
+}
+
+TEST(Packed48Vector, UsesSixBytesPerElement) {
+	packed48_vector<long> vec;
+	vec.reserve(1000);
+	EXPECT_LE(vec.memory_bytes(), 6 * 1000u + 16u);
+}
+
+} // namespace
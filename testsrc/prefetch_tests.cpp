@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <putl/prefetch.hpp>
+#include <putl/state_ptr.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace putl;
+
+struct alignas(8) Node {
+	int                                      value;
+	state_ptr<Node, std::uintptr_t, 3> next;
+};
+
+using node_ptr = state_ptr<Node, std::uintptr_t, 3>;
+
+auto next_link(node_ptr p) -> node_ptr {
+	return p->next;
+}
+
+/// \brief A link into an array of `count` nodes recording when nodes are
+///        prefetched and when they are dereferenced to reach their successor.
+struct RecordingLink {
+	std::size_t               index;
+	std::size_t               count;
+	std::vector<std::string>* events;
+
+	explicit operator bool() const noexcept {
+		return index < count;
+	}
+
+	void prefetch(prefetch_locality) const {
+		events->push_back("prefetch " + std::to_string(index));
+	}
+};
+
+auto next_recording(RecordingLink p) -> RecordingLink {
+	p.events->push_back("deref " + std::to_string(p.index));
+	return {p.index + 1, p.count, p.events};
+}
+
+TEST(Prefetch, KeepsPointerAndState) {
+	Node n{1, {nullptr, 0}};
+	node_ptr p{&n, 5};
+	p.prefetch();
+	p.prefetch(prefetch_locality::none);
+	p.prefetch(prefetch_locality::low);
+	p.prefetch(prefetch_locality::moderate);
+	EXPECT_EQ(p.get_ptr(), &n);
+	EXPECT_EQ(p.get_state(), 5u);
+}
+
+TEST(Prefetch, NullIsHarmless) {
+	node_ptr p{nullptr, 7};
+	p.prefetch();
+	EXPECT_EQ(p.get_ptr(), nullptr);
+}
+
+TEST(PrefetchChain, ReturnsKthLink) {
+	std::vector<Node> nodes(5, Node{0, {nullptr, 0}});
+	for (std::size_t i = 0; i < nodes.size(); ++i) {
+		nodes[i].value = static_cast<int>(i);
+		nodes[i].next  = {i + 1 < nodes.size() ? &nodes[i + 1] : nullptr, i % 8};
+	}
+	node_ptr const head{&nodes[0], 1};
+	EXPECT_EQ(prefetch_chain(head, 0, next_link), head);
+	EXPECT_EQ(prefetch_chain(head, 3, next_link).get_ptr(), &nodes[3]);
+	EXPECT_EQ(prefetch_chain(head, 3, next_link).get_state(), 2u);
+	EXPECT_EQ(prefetch_chain(head, 4, next_link).get_ptr(), &nodes[4]);
+	EXPECT_EQ(prefetch_chain(head, 5, next_link).get_ptr(), nullptr);
+	EXPECT_EQ(prefetch_chain(head, 100, next_link).get_ptr(), nullptr);
+}
+
+TEST(PrefetchChain, ReturnedLinkIsPrefetchedButNotDereferenced) {
+	std::vector<std::string> events;
+	RecordingLink const first{2, 6, &events};
+	auto const last = prefetch_chain(first, 1, next_recording);
+	EXPECT_EQ(last.index, 3u);
+	EXPECT_EQ(events, (std::vector<std::string>{"deref 2", "prefetch 3"}));
+}
+
+TEST(PrefetchChain, PrefetchesReachedLinksAndStopsAtNull) {
+	std::vector<std::string> events;
+	RecordingLink const first{0, 3, &events};
+	auto const last = prefetch_chain(first, 10, next_recording, prefetch_locality::low);
+	EXPECT_EQ(last.index, 3u);
+	EXPECT_EQ(events, (std::vector<std::string>{
+		"deref 0", "prefetch 1", "deref 1", "prefetch 2", "deref 2"}));
+}
+
+} // namespace
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <putl/radix_sort.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace putl;
+
+struct alignas(8) Item {
+	int value;
+};
+
+auto make_shuffled(std::vector<Item>& items, std::size_t count) -> std::vector<state_ptr<Item>> {
+	std::mt19937_64 rng{7};
+	std::vector<state_ptr<Item>> result;
+	for (std::size_t i = 0; i < count; ++i) {
+		result.emplace_back(&items[rng() % items.size()], rng() % 8);
+	}
+	return result;
+}
+
+auto address_less(state_ptr<Item> const& lhs, state_ptr<Item> const& rhs) -> bool {
+	return lhs.get_ptr() < rhs.get_ptr();
+}
+
+auto state_address_less(state_ptr<Item> const& lhs, state_ptr<Item> const& rhs) -> bool {
+	return lhs.get_state() != rhs.get_state()
+		? lhs.get_state() < rhs.get_state()
+		: lhs.get_ptr() < rhs.get_ptr();
+}
+
+TEST(RadixSort, SortByAddressIsStable) {
+	std::vector<Item> items(100);
+	auto list = make_shuffled(items, 10000);
+	auto expected = list;
+	std::stable_sort(expected.begin(), expected.end(), address_less);
+	sort_by_address(list.begin(), list.end());
+	EXPECT_EQ(list, expected);
+}
+
+TEST(RadixSort, ParallelSortByAddress) {
+	std::vector<Item> items(50000);
+	auto list = make_shuffled(items, 100000);
+	auto expected = list;
+	std::stable_sort(expected.begin(), expected.end(), address_less);
+	parallel_sort_by_address(list.begin(), list.end(), 4);
+	EXPECT_EQ(list, expected);
+}
+
+TEST(RadixSort, BucketByState) {
+	std::vector<Item> items(1000);
+	auto list = make_shuffled(items, 20000);
+	auto expected = list;
+	std::sort(expected.begin(), expected.end(), state_address_less);
+	auto const buckets = bucket_by_state(list.begin(), list.end());
+	EXPECT_EQ(list, expected);
+	ASSERT_EQ(buckets.size(), 9u);
+	EXPECT_EQ(buckets.front(), 0u);
+	EXPECT_EQ(buckets.back(), list.size());
+	for (std::size_t s = 0; s < 8; ++s) {
+		for (auto i = buckets[s]; i < buckets[s + 1]; ++i) {
+			EXPECT_EQ(list[i].get_state(), s);
+		}
+	}
+}
+
+TEST(RadixSort, ParallelBucketByState) {
+	std::vector<Item> items(1000);
+	auto list = make_shuffled(items, 100000);
+	auto expected = list;
+	std::sort(expected.begin(), expected.end(), state_address_less);
+	auto const buckets = parallel_bucket_by_state(list.begin(), list.end(), 3);
+	EXPECT_EQ(list, expected);
+	EXPECT_EQ(buckets, bucket_by_state(expected.begin(), expected.end()));
+}
+
+TEST(RadixSort, EmptyAndSingle) {
+	std::vector<state_ptr<Item>> list;
+	sort_by_address(list.begin(), list.end());
+	parallel_sort_by_address(list.begin(), list.end());
+	EXPECT_EQ(bucket_by_state(list.begin(), list.end()), std::vector<std::size_t>(9, 0));
+	Item item{1};
+	list.emplace_back(&item, 5);
+	sort_by_address(list.begin(), list.end());
+	EXPECT_EQ(list.front().get_ptr(), &item);
+	EXPECT_EQ(list.front().get_state(), 5u);
+}
+
+} // namespace
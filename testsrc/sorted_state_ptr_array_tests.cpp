@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <putl/sorted_state_ptr_array.hpp>
+
+#include <vector>
+
+namespace {
+
+using namespace putl;
+
+struct alignas(16) Node {
+	char payload[48];
+};
+
+auto make_sorted(std::vector<Node>& nodes, std::size_t stride) -> std::vector<state_ptr<Node>> {
+	std::vector<state_ptr<Node>> result;
+	for (std::size_t i = 0; i < nodes.size(); i += stride) {
+		result.emplace_back(&nodes[i], i % 16);
+	}
+	return result;
+}
+
+TEST(SortedStatePtrArray, Empty) {
+	sorted_state_ptr_array<Node> array;
+	EXPECT_TRUE(array.empty());
+	EXPECT_EQ(array.block_count(), 0u);
+	Node node;
+	EXPECT_EQ(array.lower_bound(&node), 0u);
+	EXPECT_FALSE(array.contains(&node));
+}
+
+TEST(SortedStatePtrArray, RandomAccessKeepsStates) {
+	std::vector<Node> nodes(1000);
+	auto const plain = make_sorted(nodes, 3);
+	sorted_state_ptr_array<Node> array{plain.begin(), plain.end()};
+	ASSERT_EQ(array.size(), plain.size());
+	EXPECT_EQ(array.block_count(), (plain.size() + array.block_size - 1) / array.block_size);
+	for (std::size_t i = 0; i < plain.size(); ++i) {
+		EXPECT_EQ(array[i], plain[i]);
+	}
+}
+
+TEST(SortedStatePtrArray, DecodeBlockAndForEach) {
+	std::vector<Node> nodes(777);
+	auto const plain = make_sorted(nodes, 1);
+	sorted_state_ptr_array<Node> array{plain.begin(), plain.end()};
+	std::vector<state_ptr<Node>> out(array.block_size, state_ptr<Node>{nullptr, 0});
+	std::size_t index = 0;
+	for (std::size_t block = 0; block < array.block_count(); ++block) {
+		auto const count = array.decode_block(block, out.data());
+		for (std::size_t i = 0; i < count; ++i, ++index) {
+			EXPECT_EQ(out[i], plain[index]);
+		}
+	}
+	EXPECT_EQ(index, plain.size());
+	index = 0;
+	array.for_each([&](state_ptr<Node> const& p) {
+		EXPECT_EQ(p, plain[index]);
+		++index;
+	});
+	EXPECT_EQ(index, plain.size());
+}
+
+TEST(SortedStatePtrArray, FindSkipsBlocks) {
+	std::vector<Node> nodes(2000);
+	auto const plain = make_sorted(nodes, 2);
+	sorted_state_ptr_array<Node> array{plain.begin(), plain.end()};
+	for (std::size_t i = 0; i < nodes.size(); ++i) {
+		EXPECT_EQ(array.contains(&nodes[i]), i % 2 == 0);
+		EXPECT_EQ(array.lower_bound(&nodes[i]), (i + 1) / 2);
+	}
+	EXPECT_EQ(array.find(&nodes[1]), array.size());
+	EXPECT_EQ(array.find(&nodes[10]), 5u);
+}
+
+TEST(SortedStatePtrArray, DuplicatesAndSparseBlocks) {
+	std::vector<Node> nodes(3);
+	std::vector<state_ptr<Node>> plain;
+	for (std::size_t i = 0; i < 300; ++i) {
+		plain.emplace_back(&nodes[i < 150 ? 0 : 2], 0);
+	}
+	plain.emplace_back(&nodes[2], 15);
+	sorted_state_ptr_array<Node> array{plain.begin(), plain.end()};
+	for (std::size_t i = 0; i < plain.size(); ++i) {
+		EXPECT_EQ(array[i], plain[i]);
+	}
+	EXPECT_EQ(array.find(&nodes[2]), 150u);
+	EXPECT_FALSE(array.contains(&nodes[1]));
+}
+
+TEST(SortedStatePtrArray, CompressesClusteredArrays) {
+	std::vector<Node> nodes(10000);
+	auto const plain = make_sorted(nodes, 1);
+	sorted_state_ptr_array<Node> array{plain.begin(), plain.end()};
+	EXPECT_LE(array.memory_bytes() * 3, plain.size() * sizeof(state_ptr<Node>));
+}
+
+TEST(SortedStatePtrArray, BitPacking) {
+	std::vector<std::uint64_t> values;
+	for (std::uint64_t i = 0; i < 100; ++i) {
+		values.push_back((i * 0x9E3779B97F4A7C15ull) >> 21);
+	}
+	for (unsigned width : {43u, 64u}) {
+		std::vector<std::uint64_t> packed;
+		auto const mask = width == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << width) - 1u;
+		std::vector<std::uint64_t> masked;
+		for (auto v : values) {
+			masked.push_back(v & mask);
+		}
+		detail::pack_bits(masked.data(), masked.size(), width, packed);
+		packed.push_back(0);
+		std::vector<std::uint64_t> out(masked.size());
+		detail::unpack_bits(packed.data(), width, out.size(), 5, out.data());
+		for (std::size_t i = 0; i < masked.size(); ++i) {
+			EXPECT_EQ(out[i], masked[i] + 5);
+			EXPECT_EQ(detail::unpack_bits_at(packed.data(), width, i), masked[i]);
+		}
+	}
+}
+
+TEST(SortedStatePtrArray, Unsorted) {
+	std::vector<Node> nodes(2);
+	std::vector<state_ptr<Node>> plain{{&nodes[1], 0}, {&nodes[0], 0}};
+	ASSERT_DEATH((sorted_state_ptr_array<Node>{plain.begin(), plain.end()}),
+		"elements of sorted_state_ptr_array must be sorted by address and state");
+}
+
+} // namespace
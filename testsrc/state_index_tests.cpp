@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <putl/state_index.hpp>
+
+#include <array>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+using namespace putl;
+
+struct Entity {
+	float x;
+	float y;
+};
+
+enum class Phase : std::uint32_t { Idle = 0, Active = 1, Dead = 2 };
+
+using entity_index = state_index<std::vector<Entity>, Phase, 2>;
+using wide_index   = state_index<std::vector<Entity>, std::uintptr_t, 8, std::uint64_t>;
+
+static_assert(sizeof(entity_index) == 4, "state_index must be 32-bit by default");
+static_assert(sizeof(wide_index) == 8, "state_index must be 64-bit with a 64-bit word");
+static_assert(std::is_trivially_copyable<entity_index>::value, "state_index must be trivially copyable");
+
+constexpr auto make_constexpr_index() -> entity_index {
+	entity_index i{41, Phase::Idle};
+	i.set_index(42);
+	i.set_state(Phase::Dead);
+	return i;
+}
+
+static_assert(make_constexpr_index().get_index() == 42, "state_index must be usable in constant expressions");
+static_assert(make_constexpr_index().get_state() == Phase::Dead, "state_index must be usable in constant expressions");
+
+TEST(StateIndex, IndexAndState) {
+	entity_index i{7, Phase::Active};
+	EXPECT_EQ(i.get_index(), 7u);
+	EXPECT_EQ(i.get_state(), Phase::Active);
+	i.set_state(Phase::Dead);
+	EXPECT_EQ(i.get_index(), 7u);
+	EXPECT_EQ(i.get_state(), Phase::Dead);
+	i.set_index(9);
+	EXPECT_EQ(i.get_index(), 9u);
+	EXPECT_EQ(i.get_state(), Phase::Dead);
+}
+
+TEST(StateIndex, DerefViaContainer) {
+	std::vector<Entity> entities{{1.0f, 2.0f}, {3.0f, 4.0f}};
+	entity_index i{1, Phase::Active};
+	EXPECT_EQ(i.get(entities).x, 3.0f);
+	i.get(entities).y = 5.0f;
+	EXPECT_EQ(entities[1].y, 5.0f);
+	entities.resize(1000);
+	EXPECT_EQ(i.get(entities).y, 5.0f);
+}
+
+TEST(StateIndex, Null) {
+	auto i = entity_index::null(Phase::Dead);
+	EXPECT_TRUE(i.is_null());
+	EXPECT_EQ(i.get_state(), Phase::Dead);
+	EXPECT_FALSE((entity_index{0, Phase::Idle}).is_null());
+}
+
+TEST(StateIndex, RawRoundTrip) {
+	wide_index i{123456789, 200};
+	EXPECT_EQ(wide_index::from_raw(i.raw()), i);
+	entity_index j{5, Phase::Active};
+	entity_index k;
+	std::memcpy(&k, &j, sizeof(j));
+	EXPECT_EQ(k, j);
+}
+
+TEST(StateIndex, IndexOutOfBounds) {
+	entity_index i;
+	ASSERT_DEATH(i.set_index(entity_index::max_index + 1), "index is out of bounds for this state_index");
+}
+
+TEST(AtomicStateIndex, FetchOrAndState) {
+	atomic_state_index<std::vector<Entity>, std::uint32_t, 2> a{state_index<std::vector<Entity>, std::uint32_t, 2>{17, 0}};
+	EXPECT_EQ(a.fetch_or_state(1), 0u);
+	EXPECT_EQ(a.fetch_or_state(2), 1u);
+	EXPECT_EQ(a.load().get_state(), 3u);
+	EXPECT_EQ(a.fetch_and_state(2), 3u);
+	EXPECT_EQ(a.load().get_state(), 2u);
+	EXPECT_EQ(a.load().get_index(), 17u);
+}
+
+TEST(AtomicStateIndex, CompareExchange) {
+	using index = state_index<std::vector<Entity>, std::uint32_t, 2>;
+	atomic_state_index<std::vector<Entity>, std::uint32_t, 2> a{index{1, 1}};
+	index expected{1, 0};
+	EXPECT_FALSE(a.compare_exchange_strong(expected, index{2, 2}));
+	EXPECT_EQ(expected, (index{1, 1}));
+	EXPECT_TRUE(a.compare_exchange_strong(expected, index{2, 2}));
+	EXPECT_EQ(a.load(), (index{2, 2}));
+}
+
+} // namespace
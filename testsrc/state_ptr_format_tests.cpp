@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include <putl/state_ptr_format.hpp>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace {
+
+using namespace putl;
+
+enum class Mark { None = 0, Visited = 1, Done = 2 };
+
+TEST(StatePointerFormat, ToStringOfNull) {
+	state_ptr<std::uint64_t, std::uintptr_t, 2> p{nullptr, 3};
+	EXPECT_EQ(to_string(p), "state_ptr(0x0, 3)");
+}
+
+TEST(StatePointerFormat, ToString) {
+	using ptr = state_ptr<std::uint64_t, Mark, 2>;
+	auto const p = ptr::from_raw(0x7ffd5a3c1230u | 2u);
+	EXPECT_EQ(to_string(p), "state_ptr(0x7ffd5a3c1230, 2)");
+}
+
+TEST(StatePointerFormat, ToBitString) {
+	using ptr = state_ptr<std::uint64_t, std::uintptr_t, 3>;
+	auto const bits = to_bit_string(ptr::from_raw(0x28u | 5u));
+	EXPECT_EQ(bits.size(), 8 * sizeof(std::uintptr_t) + 1);
+	EXPECT_EQ(bits.substr(bits.size() - 8), "0101|101");
+	EXPECT_EQ(bits.find_first_not_of('0'), bits.size() - 7);
+}
+
+TEST(StatePointerFormat, ToBitStringWithoutStateBits) {
+	using ptr = state_ptr<char, std::uintptr_t, 0>;
+	auto const bits = to_bit_string(ptr::from_raw(1u));
+	EXPECT_EQ(bits.size(), 8 * sizeof(std::uintptr_t));
+	EXPECT_EQ(bits.find('|'), std::string::npos);
+}
+
+TEST(StatePointerFormat, Stream) {
+	std::uint64_t value = 0;
+	state_ptr<std::uint64_t, Mark, 2> p{&value, Mark::Visited};
+	std::ostringstream os;
+	os << p;
+	EXPECT_EQ(os.str(), to_string(p));
+}
+
+} // namespace
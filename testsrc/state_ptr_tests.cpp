@@ -2,6 +2,14 @@
 
 #include <putl/state_ptr.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 namespace {
 
 using namespace putl;
@@ -63,6 +71,44 @@ TEST(StatePointer, SetStateOutOfBounds) {
 	ASSERT_DEATH(p.set_state(1337), "state value is out of bounds for this state_ptr");
 }
 
+TEST(StatePointer, ConstructMisaligned) {
+	Foo foos[2];
+	auto const misaligned = reinterpret_cast<Foo*>(reinterpret_cast<char*>(foos) + 1);
+	ASSERT_DEATH(state_ptr<Foo>(misaligned, 0), "pointer is not sufficiently aligned for this state_ptr");
+}
+
+TEST(StatePointer, UncheckedPolicy) {
+	Foo foo;
+	state_ptr<Foo, std::uintptr_t, 2, check_policy::unchecked> p{&foo, 1};
+	static_assert(noexcept(p.set_state(2)), "unchecked state_ptr must be noexcept");
+	p.set_state(2);
+	EXPECT_EQ(p.get_state(), 2u);
+	EXPECT_EQ(p.get_ptr(), &foo);
+}
+
+TEST(StatePointer, ExceptionPolicy) {
+	using checked_ptr = state_ptr<Foo, std::uintptr_t, 2, check_policy::exception>;
+	Foo foos[2];
+	static_assert(!noexcept(std::declval<checked_ptr&>().set_state(2)), "throwing state_ptr must not be noexcept");
+	EXPECT_THROW(checked_ptr(&foos[0], 4), std::out_of_range);
+	EXPECT_THROW(checked_ptr(nullptr, 4), std::out_of_range);
+	EXPECT_THROW(checked_ptr(reinterpret_cast<Foo*>(reinterpret_cast<char*>(foos) + 2), 0), std::invalid_argument);
+	checked_ptr p{&foos[1], 3};
+	EXPECT_THROW(p.set_state(4), std::out_of_range);
+	EXPECT_EQ(p.get_state(), 3u);
+}
+
+TEST(StatePointer, SampledPolicy) {
+	using sampled_ptr = state_ptr<Foo, std::uintptr_t, 2, check_policy::sampled<3>>;
+	Foo foo;
+	sampled_ptr p{&foo, 0}; // 1st write: checked
+	p.set_state(1);         // 2nd write: unchecked
+	p.set_state(2);         // 3rd write: unchecked
+	EXPECT_THROW(p.set_state(4), std::out_of_range); // 4th write: checked
+	p.set_state(3);
+	EXPECT_EQ(p.get_state(), 3u);
+}
+
 TEST(StatePointer, CopyConstructor) {
 	Foo foo;
 	state_ptr<Foo> p1{&foo, 1};
@@ -114,6 +160,64 @@ TEST(StatePointer, EqualityPtrAndState) {
 	EXPECT_NE(p11, p22);
 }
 
+TEST(StatePointer, InequalityNull) {
+	Foo foo;
+	state_ptr<Foo> p{&foo, 1};
+	state_ptr<Foo> n{nullptr, 1};
+
+	EXPECT_TRUE(p != nullptr);
+	EXPECT_TRUE(nullptr != p);
+	EXPECT_FALSE(n != nullptr);
+	EXPECT_FALSE(nullptr != n);
+	EXPECT_TRUE(nullptr == n);
+	EXPECT_FALSE(nullptr == p);
+}
+
+TEST(StatePointer, RelationalTotalOrder) {
+	Foo foos[2];
+	state_ptr<Foo> p01{&foos[0], 1};
+	state_ptr<Foo> p02{&foos[0], 2};
+	state_ptr<Foo> p11{&foos[1], 1};
+
+	// Ordered by address first and by state second.
+	EXPECT_LT(p01, p02);
+	EXPECT_LT(p02, p11);
+	EXPECT_LT(p01, p11);
+	EXPECT_LE(p01, p01);
+	EXPECT_GE(p01, p01);
+	EXPECT_GT(p11, p02);
+	EXPECT_GE(p11, p01);
+	EXPECT_FALSE(p01 < p01);
+	EXPECT_FALSE(p02 <= p01);
+	EXPECT_FALSE(p01 > p02);
+	EXPECT_FALSE(p01 >= p02);
+}
+
+TEST(StatePointer, OrderedContainers) {
+	Foo foos[3];
+	std::vector<state_ptr<Foo>> ptrs{{&foos[2], 0}, {&foos[0], 3}, {&foos[1], 1}, {&foos[0], 1}};
+	std::sort(ptrs.begin(), ptrs.end());
+	EXPECT_EQ(ptrs, (std::vector<state_ptr<Foo>>{{&foos[0], 1}, {&foos[0], 3}, {&foos[1], 1}, {&foos[2], 0}}));
+
+	std::set<state_ptr<Foo>> by_word(ptrs.begin(), ptrs.end());
+	EXPECT_EQ(by_word.size(), 4u);
+
+	std::set<state_ptr<Foo>, state_ptr_address_less> by_address(ptrs.begin(), ptrs.end());
+	EXPECT_EQ(by_address.size(), 3u);
+	EXPECT_EQ(by_address.count(state_ptr<Foo>{&foos[0], 2}), 1u);
+}
+
+TEST(StatePointer, Hash) {
+	Foo foo;
+	std::unordered_set<state_ptr<Foo>> set;
+	set.insert(state_ptr<Foo>{&foo, 1});
+	set.insert(state_ptr<Foo>{&foo, 2});
+	set.insert(state_ptr<Foo>{&foo, 1});
+	EXPECT_EQ(set.size(), 2u);
+	EXPECT_EQ(set.count(state_ptr<Foo>{&foo, 2}), 1u);
+	EXPECT_EQ(std::hash<state_ptr<Foo>>()(state_ptr<Foo>{&foo, 1}), std::hash<state_ptr<Foo>>()(state_ptr<Foo>{&foo, 1}));
+}
+
 TEST(StatePointer, DerefOp) {
 	int foo1{42};
 	int foo2{1337};
@@ -144,6 +248,18 @@ TEST(StatePointer, ImplicitBoolConversion) {
 	EXPECT_FALSE(p2);
 }
 
+struct ListNode {
+	int value;
+	state_ptr<ListNode, std::uintptr_t, 2> next;
+};
+
+TEST(StatePointer, SelfReferentialType) {
+	ListNode tail{2, {nullptr, 0}};
+	ListNode head{1, {&tail, 3}};
+	EXPECT_EQ(head.next->value, 2);
+	EXPECT_EQ(head.next.get_state(), 3u);
+}
+
 TEST(StatePointer, RegressionGitHubIssue4) {
 	// Compile-time regression where apple-clang reported the following error:
 	// 
@@ -160,4 +276,61 @@ TEST(StatePointer, RegressionGitHubIssue4) {
 	ASSERT_EQ(target, 1);
 }
 
+TEST(StatePointer, Layout) {
+#if UTILS_STATE_PTR_SEPARATE_FIELDS
+	static_assert(sizeof(state_ptr<int>) == 2 * sizeof(void*), "state_ptr must store pointer and state separately");
+	// The untagged address must be stored verbatim for leak checkers to find it.
+	int value = 0;
+	state_ptr<int> p{&value, 3};
+	void* words[2];
+	std::memcpy(words, &p, sizeof(p));
+	EXPECT_TRUE(words[0] == &value || words[1] == &value);
+#else
+	static_assert(sizeof(state_ptr<int>) == sizeof(void*), "state_ptr must be pointer-sized");
+#endif
+}
+
+TEST(StatePointer, LayoutConstants) {
+	using layout = state_ptr<Foo, Bar, 2>::layout;
+	static_assert(layout::word_bits == 8 * sizeof(void*), "");
+	static_assert(layout::state_bits == 2, "");
+	static_assert(layout::ptr_bits == layout::word_bits - 2, "");
+	static_assert(layout::state_shift == 0, "");
+	static_assert(layout::ptr_shift == 2, "");
+	static_assert(layout::state_mask == 0x3u, "");
+	static_assert(layout::ptr_mask == ~std::uintptr_t{0x3u}, "");
+	static_assert(layout::state_max == 3, "");
+	// Layout constants are usable by reference.
+	EXPECT_EQ(layout::state_max, 3u);
+	EXPECT_EQ(std::max(layout::state_bits, std::size_t{1}), 2u);
+}
+
+TEST(StatePointer, LayoutOfIncompleteType) {
+	struct Node;
+	static_assert(state_ptr<Node, std::uintptr_t, 1>::layout::state_mask == 1u, "");
+}
+
+TEST(StatePointer, FromRawRoundTrip) {
+	Foo foo{5};
+	state_ptr<Foo, Bar, 2> const p{&foo, C};
+	auto const q = state_ptr<Foo, Bar, 2>::from_raw(p.raw());
+	EXPECT_EQ(q, p);
+	EXPECT_EQ(q->get_a(), 5);
+	EXPECT_EQ(q.get_state(), C);
+	constexpr auto r = state_ptr<Foo, Bar, 2>::from_raw(2u);
+	static_assert(r.get_state() == C, "");
+	static_assert(!r, "");
+}
+
+TEST(StatePointer, PackedRepresentationIsLayoutIndependent) {
+	int value = 0;
+	state_ptr<int> p{&value, 2};
+	auto const bits = p.raw();
+	EXPECT_EQ(bits, reinterpret_cast<std::uintptr_t>(&value) | 2u);
+	auto const q = state_ptr<int>::from_raw(bits);
+	EXPECT_EQ(q, p);
+	EXPECT_EQ(q.get_ptr(), &value);
+	EXPECT_EQ(q.get_state(), 2u);
+}
+
 } // namespace
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <putl/atomic_state_ptr.hpp>
+#include <putl/state_ptr.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+
+namespace {
+
+enum class Color : std::uint8_t { Red = 0, Green = 1, Blue = 2 };
+enum class Flag { Off = 0, On = 1 };
+enum class Raw { Zero = 0, Seven = 7 };
+
+} // namespace
+
+namespace putl {
+	template<>
+	struct state_traits<Color> {
+		constexpr static std::uintptr_t max_value = static_cast<std::uintptr_t>(Color::Blue);
+	};
+
+	template<>
+	struct state_traits<Flag> {
+		constexpr static std::uintptr_t max_value = static_cast<std::uintptr_t>(Flag::On);
+	};
+}
+
+namespace {
+
+using namespace putl;
+
+static_assert(detail::default_state_bits<std::uint64_t, Color>() == 2, "Color requires 2 state bits");
+static_assert(detail::default_state_bits<std::uint64_t, Flag>() == 1, "Flag requires 1 state bit");
+static_assert(detail::default_state_bits<std::uint64_t, Raw>() == 3, "Raw uses all bits freed by the alignment");
+static_assert(detail::default_state_bits<std::uint64_t, std::uintptr_t>() == 3, "integers use all bits freed by the alignment");
+
+struct TreeNode {
+	int value;
+	// No explicit state bits required since alignof(TreeNode) is not needed.
+	state_ptr<TreeNode, Color> left;
+	state_ptr<TreeNode, Color> right;
+};
+
+TEST(StateTraits, DeducedStateBitsLeaveLowBitsFree) {
+	std::uint64_t value = 0;
+	state_ptr<std::uint64_t, Flag> p{&value, Flag::On};
+	EXPECT_EQ(p.get_ptr(), &value);
+	EXPECT_EQ(p.get_state(), Flag::On);
+	// Only the lowest bit is occupied by the state.
+	EXPECT_EQ(p.raw() & 0x6u, 0u);
+}
+
+TEST(StateTraits, SelfReferentialType) {
+	TreeNode leaf{2, {nullptr, Color::Red}, {nullptr, Color::Red}};
+	TreeNode root{1, {&leaf, Color::Blue}, {nullptr, Color::Green}};
+	EXPECT_EQ(root.left->value, 2);
+	EXPECT_EQ(root.left.get_state(), Color::Blue);
+	EXPECT_EQ(root.right.get_state(), Color::Green);
+	EXPECT_EQ(root.right, nullptr);
+}
+
+TEST(StateTraits, BoundedStatesAreNotCheckedAtRuntime) {
+	std::uint64_t value = 0;
+	// The exception policy still detects misaligned pointers, but the states
+	// of Color are proven to fit at compile-time.
+	using ptr = state_ptr<std::uint64_t, Color, 2, check_policy::exception>;
+	ptr p{&value, Color::Green};
+	EXPECT_NO_THROW(p.set_state(Color::Blue));
+	EXPECT_EQ(p.get_state(), Color::Blue);
+	auto const misaligned = reinterpret_cast<std::uint64_t*>(reinterpret_cast<char*>(&value) + 1);
+	EXPECT_THROW((ptr{misaligned, Color::Red}), std::invalid_argument);
+}
+
+TEST(StateTraits, ExplicitStateBitsAreStillAllowed) {
+	std::uint64_t value = 0;
+	state_ptr<std::uint64_t, Color, 3> p{&value, Color::Blue};
+	EXPECT_EQ(p.get_state(), Color::Blue);
+}
+
+TEST(StateTraits, AtomicStatePtr) {
+	std::uint64_t value = 0;
+	atomic_state_ptr<std::uint64_t, Color> a{{&value, Color::Red}};
+	a.store({&value, Color::Blue});
+	EXPECT_EQ(a.load().get_state(), Color::Blue);
+	EXPECT_EQ(a.load().get_ptr(), &value);
+}
+
+} // namespace
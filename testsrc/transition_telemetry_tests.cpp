@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <putl/transition_telemetry.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace putl;
+
+enum class Page : std::uintptr_t { Clean = 0, Dirty = 1, Writeback = 2 };
+
+struct alignas(4) Frame {
+	int data;
+};
+
+struct SingleThreadTag {};
+struct MultiThreadTag {};
+struct SampledTag {};
+struct ResetTag {};
+struct NarrowTag {};
+
+template<typename Tag, std::uint32_t N = 1>
+using page_ptr = state_ptr<Frame, Page, 2, check_policy::instrumented<transition_telemetry<2, Tag, N>>>;
+
+TEST(TransitionTelemetry, CountsTransitions) {
+	using telemetry = transition_telemetry<2, SingleThreadTag>;
+	Frame frame{0};
+	page_ptr<SingleThreadTag> p{&frame, Page::Clean};
+	p.set_state(Page::Dirty);
+	p.set_state(Page::Writeback);
+	p.set_state(Page::Clean);
+	p.set_state(Page::Dirty);
+	p.set_state(Page::Dirty);
+	auto const matrix = telemetry::snapshot();
+	EXPECT_EQ(matrix.states(), 4u);
+	EXPECT_EQ(matrix.count(0, 1), 2u);
+	EXPECT_EQ(matrix.count(1, 2), 1u);
+	EXPECT_EQ(matrix.count(2, 0), 1u);
+	EXPECT_EQ(matrix.count(1, 1), 1u);
+	EXPECT_EQ(matrix.count(1, 0), 0u);
+	EXPECT_EQ(matrix.total(), 5u);
+	EXPECT_EQ(p.get_state(), Page::Dirty);
+	EXPECT_EQ(p.get_ptr(), &frame);
+}
+
+TEST(TransitionTelemetry, AggregatesThreads) {
+	using telemetry = transition_telemetry<2, MultiThreadTag>;
+	constexpr std::size_t threads     = 4;
+	constexpr std::size_t transitions = 1000;
+	std::vector<std::thread> workers;
+	for (std::size_t t = 0; t < threads; ++t) {
+		workers.emplace_back([] {
+			Frame frame{0};
+			page_ptr<MultiThreadTag> p{&frame, Page::Clean};
+			for (std::size_t i = 0; i < transitions; ++i) {
+				p.set_state(Page::Dirty);
+				p.set_state(Page::Clean);
+			}
+		});
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	auto const matrix = telemetry::snapshot();
+	EXPECT_EQ(matrix.count(0, 1), threads * transitions);
+	EXPECT_EQ(matrix.count(1, 0), threads * transitions);
+	EXPECT_EQ(matrix.total(), 2 * threads * transitions);
+}
+
+TEST(TransitionTelemetry, SampledTransitionsAreWeighted) {
+	using telemetry = transition_telemetry<2, SampledTag, 8>;
+	Frame frame{0};
+	page_ptr<SampledTag, 8> p{&frame, Page::Clean};
+	for (std::size_t i = 0; i < 64; ++i) {
+		p.set_state(Page::Dirty);
+	}
+	auto const matrix = telemetry::snapshot();
+	// Transitions are sampled per thread, not per kind of transition.
+	EXPECT_EQ(matrix.total(), 64u);
+}
+
+TEST(TransitionTelemetry, Reset) {
+	using telemetry = transition_telemetry<2, ResetTag>;
+	Frame frame{0};
+	page_ptr<ResetTag> p{&frame, Page::Clean};
+	p.set_state(Page::Dirty);
+	EXPECT_EQ(telemetry::snapshot().total(), 1u);
+	telemetry::reset();
+	EXPECT_EQ(telemetry::snapshot().total(), 0u);
+	p.set_state(Page::Clean);
+	EXPECT_EQ(telemetry::snapshot().count(1, 0), 1u);
+}
+
+TEST(TransitionTelemetry, InstrumentedKeepsBaseChecks) {
+	using ptr = state_ptr<Frame, std::uintptr_t, 2, check_policy::instrumented<transition_telemetry<2, ResetTag>, check_policy::exception>>;
+	Frame frame{0};
+	ptr p{&frame, 0};
+	EXPECT_THROW(p.set_state(4), std::out_of_range);
+}
+
+TEST(TransitionTelemetry, InstrumentedSetStateIsNotNoexcept) {
+	// The first transition of a thread allocates its counters.
+	static_assert(!noexcept(std::declval<page_ptr<SingleThreadTag>&>().set_state(Page::Dirty)),
+		"set_state of an instrumented state_ptr may throw.");
+	static_assert(noexcept(std::declval<state_ptr<Frame, Page, 2>&>().set_state(Page::Dirty)),
+		"set_state of a state_ptr with the default policy never throws.");
+}
+
+TEST(TransitionTelemetry, RecordsStatePointersWithFewerStateBits) {
+	// A state_ptr with more state bits than the telemetry is rejected at compile-time.
+	using telemetry = transition_telemetry<2, NarrowTag>;
+	using ptr = state_ptr<Frame, std::uintptr_t, 1, check_policy::instrumented<telemetry>>;
+	Frame frame{0};
+	ptr p{&frame, 0};
+	p.set_state(1);
+	EXPECT_EQ(telemetry::snapshot().count(0, 1), 1u);
+}
+
+} // namespace